@@ -0,0 +1,161 @@
+/*
+ * This file is part of the PLATFORM_OBJ distribution
+ * {https://github.com/amatarazzo777/platform_obj). Copyright (c) 2020 Anthony
+ * Matarazzo.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+\author Anthony Matarazzo
+\file blur_benchmark.cpp
+\date 9/7/20
+\version 1.0
+\brief measures the stack blur of blur_image against stack_blur_scalar on
+surfaces of the sizes of text shadows and large glows, and checks the results
+are the same. Then measures each blur engine as the radius grows, for ARGB32
+images and A8 shadow masks.
+*/
+
+#include "uxdevice.hpp"
+
+using namespace std;
+using namespace uxdevice;
+
+namespace {
+typedef void (*blur_function_t)(cairo_surface_t *img, unsigned int radius);
+
+/// @brief an image surface of random pixels.
+cairo_surface_t *noise_surface(int w, int h, std::mt19937 &rng,
+                               cairo_format_t format = CAIRO_FORMAT_ARGB32) {
+  cairo_surface_t *img = cairo_image_surface_create(format, w, h);
+  cairo_surface_flush(img);
+  std::uint8_t *data = cairo_image_surface_get_data(img);
+  int stride = cairo_image_surface_get_stride(img);
+  for (int n = 0; n < stride * h; n++)
+    data[n] = static_cast<std::uint8_t>(rng());
+  cairo_surface_mark_dirty(img);
+  return img;
+}
+
+/// @brief a copy of the surface.
+cairo_surface_t *copy_surface(cairo_surface_t *img) {
+  int h = cairo_image_surface_get_height(img);
+  int stride = cairo_image_surface_get_stride(img);
+  cairo_surface_t *copy = cairo_image_surface_create(
+      cairo_image_surface_get_format(img), cairo_image_surface_get_width(img),
+      h);
+  cairo_surface_flush(copy);
+  std::memcpy(cairo_image_surface_get_data(copy),
+              cairo_image_surface_get_data(img), stride * h);
+  cairo_surface_mark_dirty(copy);
+  return copy;
+}
+
+/// @brief milliseconds per blur, the least of several runs.
+double measure(blur_function_t fn, cairo_surface_t *img, unsigned int radius,
+               int runs) {
+  double best = std::numeric_limits<double>::max();
+  for (int n = 0; n < runs; n++) {
+    auto start = std::chrono::steady_clock::now();
+    fn(img, radius);
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(
+        best, std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return best;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::mt19937 rng(7);
+  bool bSame = true;
+
+  std::cout << std::setw(11) << "size" << std::setw(8) << "radius"
+            << std::setw(12) << "scalar ms" << std::setw(12) << "blur ms"
+            << std::setw(10) << "speedup" << std::endl;
+
+  for (auto size : {std::array<int, 2>{320, 48}, std::array<int, 2>{512, 512},
+                    std::array<int, 2>{1920, 1080}}) {
+    for (unsigned int radius : {4u, 16u, 64u}) {
+      cairo_surface_t *scalar = noise_surface(size[0], size[1], rng);
+      cairo_surface_t *vector = copy_surface(scalar);
+
+      int runs = size[0] * size[1] > 1000000 ? 3 : 10;
+      double scalar_ms = measure(stack_blur_scalar, scalar, radius, runs);
+      double vector_ms = measure(
+          [](cairo_surface_t *img, unsigned int radius) {
+            blur_image(img, radius, blur_engine_t::stack);
+          },
+          vector, radius, runs);
+
+      int h = cairo_image_surface_get_height(scalar);
+      int stride = cairo_image_surface_get_stride(scalar);
+      bool bEqual = std::memcmp(cairo_image_surface_get_data(scalar),
+                                cairo_image_surface_get_data(vector),
+                                stride * h) == 0;
+      bSame = bSame && bEqual;
+
+      std::cout << std::setw(5) << size[0] << "x" << std::setw(5) << size[1]
+                << std::setw(8) << radius << std::fixed
+                << std::setprecision(2) << std::setw(12) << scalar_ms
+                << std::setw(12) << vector_ms << std::setw(9)
+                << scalar_ms / vector_ms << "x"
+                << (bEqual ? "" : "  results differ") << std::endl;
+
+      cairo_surface_destroy(scalar);
+      cairo_surface_destroy(vector);
+    }
+  }
+
+  // the engines, on a surface the size of a large glow. Images are ARGB32
+  // and shadows are A8 masks, which blur a different number of lines at a
+  // time, so each format is reported.
+  std::cout << std::endl
+            << std::setw(11) << "engine" << std::setw(8) << "format"
+            << std::setw(8) << "radius" << std::setw(12) << "ms" << std::endl;
+
+  const std::array<std::pair<const char *, blur_engine_t>, 3> engines = {
+      std::make_pair("stack", blur_engine_t::stack),
+      std::make_pair("box", blur_engine_t::box),
+      std::make_pair("scaled", blur_engine_t::scaled)};
+
+  const std::array<std::pair<const char *, cairo_format_t>, 2> formats = {
+      std::make_pair("ARGB32", CAIRO_FORMAT_ARGB32),
+      std::make_pair("A8", CAIRO_FORMAT_A8)};
+
+  for (auto &engine : engines) {
+    for (auto &format : formats) {
+      for (unsigned int radius : {8u, 32u, 128u, 512u}) {
+        cairo_surface_t *img = noise_surface(1024, 1024, rng, format.second);
+        double best = std::numeric_limits<double>::max();
+        for (int n = 0; n < 3; n++) {
+          auto start = std::chrono::steady_clock::now();
+          blur_image(img, radius, engine.second);
+          auto end = std::chrono::steady_clock::now();
+          best = std::min(
+              best,
+              std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::cout << std::setw(11) << engine.first << std::setw(8)
+                  << format.first << std::setw(8) << radius << std::fixed
+                  << std::setprecision(2) << std::setw(12) << best
+                  << std::endl;
+        cairo_surface_destroy(img);
+      }
+    }
+  }
+
+  return bSame ? 0 : 1;
+}
+
@@ -46,6 +46,7 @@
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <thread>
 
@@ -72,8 +73,16 @@
 #include <variant>
 #include <vector>
 
+#include <fcntl.h>
 #include <sys/ipc.h>
+#include <sys/mman.h>
 #include <sys/shm.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include <X11/Xlib-xcb.h>
 #include <X11/Xutil.h>
@@ -85,6 +94,7 @@
 
 #include <cairo-xcb.h>
 #include <cairo.h>
+#include <png.h>
 
 #include <glib.h>
 #include <librsvg/rsvg.h>
@@ -146,75 +156,212 @@ void hash_combine(std::size_t &seed, const T &v, const Rest &... rest) {
 inherited in. The mechanism provides typed index storage of objects that may be
 referenced at any time.
 
+\details Each type stored is given a slot number the first time it is used.
+The slot is held within a function local static so the lookup of a type is
+an index into a vector rather than hashing a std::type_index. The hash
+function of a slot is a plain function pointer instantiated for the type, so
+storing an object does not allocate beyond the vector growing once.
 */
 namespace uxdevice {
-typedef std::function<std::size_t(void)> hash_function_t;
+typedef std::size_t (*hash_function_t)(const void *);
 
 class unit_memory_object_t {
 public:
-  std::any object = {};
-  hash_function_t hash_function = {};
+  std::shared_ptr<void> object = {};
+  hash_function_t hash_function = nullptr;
 };
 
-typedef std::unordered_map<std::type_index, unit_memory_object_t>
-    unit_memory_unordered_map_t;
+typedef std::vector<unit_memory_object_t> unit_memory_slots_t;
 class display_unit_t;
 class unit_memory_storage_t {
 public:
   unit_memory_storage_t() {}
   virtual ~unit_memory_storage_t() {}
+
+  /// @brief the slot of the type. Assigned once per type for the process.
+  template <typename T> static std::size_t unit_memory_slot(void) noexcept {
+    static const std::size_t slot = next_unit_memory_slot()++;
+    return slot;
+  }
+
   template <typename T> void unit_memory(const std::shared_ptr<T> ptr) {
-    auto ti = std::type_index(typeid(T));
-    storage[ti] = unit_memory_object_t{ptr, [&]() { return ptr->hash_code(); }};
+    auto &item = slot_reference(unit_memory_slot<T>());
+    item.object = ptr;
+    item.hash_function = [](const void *p) {
+      return static_cast<const T *>(p)->hash_code();
+    };
   }
 
   template <typename T>
   void unit_memory(const std::shared_ptr<display_unit_t> ptr) {
-    auto ti = std::type_index(typeid(T));
-    storage[ti] = unit_memory_object_t{
-        std::dynamic_pointer_cast<T>(ptr),
-        [&]() { return std::dynamic_pointer_cast<T>(ptr)->hash_code(); }};
+    unit_memory<T>(std::dynamic_pointer_cast<T>(ptr));
   }
 
   template <typename T>
   auto unit_memory(void) const noexcept -> const std::shared_ptr<T> {
-    std::shared_ptr<T> ptr = {};
-    auto ti = std::type_index(typeid(T));
-    auto item = storage.find(ti);
-    if (item != storage.end()) {
-      auto obj_data = item->second.object;
-      ptr = std::any_cast<std::shared_ptr<T>>(obj_data);
-    }
-    return ptr;
+    std::size_t slot = unit_memory_slot<T>();
+    if (slot < storage.size())
+      return std::static_pointer_cast<T>(storage[slot].object);
+    return {};
   }
   void copy_unit_memory(const unit_memory_storage_t &other) {
     storage = other.storage;
   }
   template <typename T> void unit_memory_erase(void) {
-    storage.erase(std::type_index(typeid(T)));
+    std::size_t slot = unit_memory_slot<T>();
+    if (slot < storage.size())
+      storage[slot] = {};
   }
 
   std::size_t unit_memory_hash_code(void) const noexcept {
     std::size_t value = {};
-    for (auto &n : storage) {
-      hash_combine(value, n.second.hash_function());
-    }
+    for (auto &n : storage)
+      if (n.object)
+        hash_combine(value, n.hash_function(n.object.get()));
     return value;
   }
 
   template <typename T> std::size_t unit_memory_hash_code(void) {
     std::size_t value = {};
-    auto ti = std::type_index(typeid(T));
-    auto item = storage.find(ti);
-    if (item != storage.end()) {
-      value = item->second.hash_function();
-    }
+    std::size_t slot = unit_memory_slot<T>();
+    if (slot < storage.size() && storage[slot].object)
+      value = storage[slot].hash_function(storage[slot].object.get());
     return value;
   }
   void unit_memory_clear(void) { storage.clear(); }
 
 private:
-  unit_memory_unordered_map_t storage = {};
+  static std::atomic<std::size_t> &next_unit_memory_slot(void) noexcept {
+    static std::atomic<std::size_t> next = {};
+    return next;
+  }
+
+  unit_memory_object_t &slot_reference(std::size_t slot) {
+    if (slot >= storage.size())
+      storage.resize(slot + 1);
+    return storage[slot];
+  }
+
+  unit_memory_slots_t storage = {};
+};
+
+} // namespace uxdevice
+
+/**
+\internal
+\class mapped_file_t
+\brief a read only memory mapping of a file. The pages are loaded by the
+operating system as they are touched, so large files are not read into
+memory as a whole. The mapping is released when the object is destroyed.
+*/
+namespace uxdevice {
+class mapped_file_t {
+public:
+  mapped_file_t() {}
+  mapped_file_t(const std::string &file_name) {
+    int fd = open(file_name.data(), O_RDONLY);
+    if (fd == -1)
+      return;
+
+    struct stat file_stat = {};
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+      void *p = mmap(nullptr, static_cast<std::size_t>(file_stat.st_size),
+                     PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        _data = static_cast<const char *>(p);
+        _size = static_cast<std::size_t>(file_stat.st_size);
+        _modified = file_stat.st_mtim;
+      }
+    }
+    close(fd);
+  }
+  mapped_file_t(const mapped_file_t &other) = delete;
+  mapped_file_t &operator=(const mapped_file_t &other) = delete;
+  ~mapped_file_t() {
+    if (_data)
+      munmap(const_cast<char *>(_data), _size);
+  }
+
+  /// @brief advises the system of the access pattern of the mapping.
+  void advise(int advice) {
+    if (_data)
+      madvise(const_cast<char *>(_data), _size, advice);
+  }
+
+  bool is_valid(void) const noexcept { return _data != nullptr; }
+  const char *data(void) const noexcept { return _data; }
+  std::size_t size(void) const noexcept { return _size; }
+
+  /// @brief true when the status of the file is that of the mapped file.
+  bool is_current(const struct stat &file_stat) const noexcept {
+    return static_cast<std::size_t>(file_stat.st_size) == _size &&
+           file_stat.st_mtim.tv_sec == _modified.tv_sec &&
+           file_stat.st_mtim.tv_nsec == _modified.tv_nsec;
+  }
+
+private:
+  const char *_data = nullptr;
+  std::size_t _size = {};
+  struct timespec _modified = {};
 };
+} // namespace uxdevice
+
+/**
+\internal
+\class background_work_t
+\brief a fixed number of threads executing submitted work in the order it
+was received. Work still queued when the object is destroyed is completed
+before the threads are joined.
+*/
+namespace uxdevice {
+class background_work_t {
+public:
+  typedef std::function<void(void)> work_t;
 
+  background_work_t(std::size_t threads = 1) {
+    for (std::size_t i = 0; i < std::max(threads, std::size_t{1}); i++)
+      workers.emplace_back(&background_work_t::run, this);
+  }
+  background_work_t(const background_work_t &other) = delete;
+  background_work_t &operator=(const background_work_t &other) = delete;
+  ~background_work_t() {
+    {
+      std::lock_guard<std::mutex> lock(work_mutex);
+      bQuit = true;
+    }
+    work_available.notify_all();
+    for (auto &t : workers)
+      t.join();
+  }
+
+  void submit(work_t fn) {
+    {
+      std::lock_guard<std::mutex> lock(work_mutex);
+      work.emplace_back(std::move(fn));
+    }
+    work_available.notify_one();
+  }
+
+private:
+  void run(void) {
+    while (true) {
+      work_t fn = {};
+      {
+        std::unique_lock<std::mutex> lock(work_mutex);
+        work_available.wait(lock, [this]() { return bQuit || !work.empty(); });
+        if (work.empty())
+          return;
+        fn = std::move(work.front());
+        work.pop_front();
+      }
+      fn();
+    }
+  }
+
+  std::mutex work_mutex = {};
+  std::condition_variable work_available = {};
+  std::list<work_t> work = {};
+  std::vector<std::thread> workers = {};
+  bool bQuit = false;
+};
 } // namespace uxdevice
@@ -28,30 +28,335 @@
 
 namespace uxdevice {
 
+/**
+\internal
+\class mapped_file_cache_t
+\brief process wide cache of mapped asset files. Files read repeatedly are
+mapped once. A cached mapping is used while the size and modification time
+of the file are unchanged.
+*/
+class mapped_file_cache_t {
+public:
+  typedef std::shared_ptr<mapped_file_t> mapped_file_ptr_t;
+
+  static mapped_file_ptr_t acquire(const std::string &file_name);
+  static void clear(void);
+
+  static constexpr std::size_t limit = 256;
+
+private:
+  static void trim(void);
+};
+
 cairo_surface_t *read_image(std::string &data, double w = -1, double h = -1);
+bool base64_decode(const std::string_view &text,
+                   std::vector<std::uint8_t> &bytes);
 cairo_status_t read_contents(const gchar *file_name, guint8 **contents,
                              gsize *length);
 
 cairo_surface_t *image_surface_SVG(bool bDataPassed, std::string &data,
                                    double width = -1, double height = -1);
 
-#if defined(USE_STACKBLUR)
+/**
+\internal
+\class decoded_image_t
+\brief an image decoded by the image decode threads. The image may only be
+used once is_ready() returns true. It is nullptr when the image could not be
+read.
+*/
+class decoded_image_t {
+public:
+  decoded_image_t() {}
+  decoded_image_t(const decoded_image_t &other) = delete;
+  decoded_image_t &operator=(const decoded_image_t &other) = delete;
+  ~decoded_image_t() {
+    if (image)
+      cairo_surface_destroy(image);
+  }
+
+  bool is_ready(void) const noexcept { return ready; }
+
+  cairo_surface_t *image = nullptr;
+  std::atomic<bool> ready = false;
+};
+
+/**
+\internal
+\class image_cache_key_t
+\brief identifies a decoded image by its description, which is the file name
+or the inline data, and the size requested. The description is hashed once
+and compared when keys are equal in hash. The filter is not part of the key
+as it does not change the decoded pixels. It is set on the pattern that
+paints the image.
+*/
+class image_cache_key_t {
+public:
+  bool operator==(const image_cache_key_t &other) const noexcept {
+    return content_hash == other.content_hash && width == other.width &&
+           height == other.height && description == other.description;
+  }
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, content_hash, width, height);
+    return __value;
+  }
+
+  std::size_t content_hash = {};
+  std::string description = {};
+  int width = {};
+  int height = {};
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::image_cache_key_t);
+
+namespace uxdevice {
+/**
+\internal
+\class image_cache_t
+\brief process wide cache of decoded images. Objects naming the same image
+at the same size share one surface, so it is decoded once. acquire() decodes
+on the image decode threads and returns at once. The functions waiting upon
+an image are called from the decode thread when it is ready. read() decodes
+on the calling thread. When the decoded images exceed the memory budget,
+images no longer used outside of the cache are released.
+*/
+class image_cache_t {
+public:
+  typedef std::shared_ptr<decoded_image_t> decoded_image_ptr_t;
+  typedef std::function<void(cairo_surface_t *image)> image_ready_t;
+
+  static decoded_image_ptr_t acquire(const std::string &data, double w,
+                                     double h, const image_ready_t &fn_ready);
+  static decoded_image_ptr_t read(const std::string &data, double w,
+                                  double h);
+  static void clear(void);
+
+  static constexpr std::size_t budget = 128 * 1024 * 1024;
+
+private:
+  static image_cache_key_t key(const std::string &data, double w, double h);
+  static void trim(void);
+};
+
+/**
+\internal
+\class svg_image_t
+\brief a parsed svg document and its rasterizations at power of two
+scales of the requested size. The level drawn is chosen by the device scale
+and the transformation of the cairo context. When the level is not ready, the
+nearest level that is ready is scaled while the level is rasterized on the
+image decode threads. Objects naming the same document at the same size share
+it through acquire().
+*/
+class svg_image_t : public std::enable_shared_from_this<svg_image_t> {
+public:
+  typedef std::shared_ptr<svg_image_t> svg_image_ptr_t;
+
+  svg_image_t(const std::string &_data, double w, double h)
+      : data(_data), width(w), height(h) {}
+  svg_image_t(const svg_image_t &other) = delete;
+  svg_image_t &operator=(const svg_image_t &other) = delete;
+  ~svg_image_t() {
+    if (handle)
+      g_object_unref(handle);
+  }
+
+  static svg_image_ptr_t acquire(const std::string &data, double w, double h);
+  static bool is_svg(const std::string &data);
+
+  void request(cairo_t *cr, const image_cache_t::image_ready_t &fn_ready);
+  bool set_source(cairo_t *cr, double x, double y,
+                  const image_cache_t::image_ready_t &fn_ready);
+  static double scale(cairo_t *cr);
+
+  static constexpr int min_level = -2;
+  static constexpr int max_level = 3;
+  static constexpr double max_pixels = 4096;
+
+  // a level more than two steps from the one drawn is released once it has
+  // not been drawn for this long.
+  static constexpr std::chrono::milliseconds retain =
+      std::chrono::milliseconds(2000);
+
+private:
+  int level(double _scale) const;
+  void request_level(int k, const image_cache_t::image_ready_t &fn_ready);
+  cairo_surface_t *rasterize(int k);
+
+  std::string data = {};
+  double width = {};
+  double height = {};
+
+  // the parsed document, used by one decode thread at a time.
+  std::mutex render_lock = {};
+  RsvgHandle *handle = nullptr;
+  bool parsed = {};
+
+  // the levels, from min_level through max_level.
+  std::mutex lock = {};
+  std::array<image_cache_t::decoded_image_ptr_t, max_level - min_level + 1>
+      levels = {};
+  std::array<std::vector<image_cache_t::image_ready_t>,
+             max_level - min_level + 1>
+      waiters = {};
+
+  // when each level was last drawn, by any object sharing the document.
+  std::array<std::chrono::steady_clock::time_point, max_level - min_level + 1>
+      drawn_at = {};
+};
+
+/**
+\internal
+\class image_tile_source_t
+\brief reads square tiles of an image without decoding all of it. The image
+at a level is reduced by 2^level. Levels below zero magnify, which only svg
+documents allow. A png is decoded row by row through the last row of the
+tiles read and only the pixels of those tiles are kept. Interlaced png data
+cannot be read in rows and is not opened.
+*/
+class image_tile_source_t {
+public:
+  typedef std::function<void(int column, int row, cairo_surface_t *tile)>
+      tile_read_t;
+
+  virtual ~image_tile_source_t() {}
+
+  static std::unique_ptr<image_tile_source_t> open(const std::string &data);
+
+  /// @brief reads the tiles of the level within the rectangle, given in
+  /// tiles. fn_tile takes ownership of each tile read. Returns false when
+  /// the tiles could not be read.
+  virtual bool read(int level, const cairo_rectangle_int_t &tiles,
+                    const tile_read_t &fn_tile) = 0;
+
+  static constexpr int tile_size = 256;
+
+  int width = {};
+  int height = {};
+  int min_level = {};
+};
+
+/**
+\internal
+\class image_tile_key_t
+\brief identifies a tile by its level, column and row.
+*/
+class image_tile_key_t {
+public:
+  bool operator==(const image_tile_key_t &other) const noexcept {
+    return level == other.level && column == other.column && row == other.row;
+  }
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, level, column, row);
+    return __value;
+  }
+
+  int level = {};
+  int column = {};
+  int row = {};
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::image_tile_key_t);
+
+namespace uxdevice {
+/**
+\internal
+\class image_tiles_t
+\brief a large image drawn from tiles read on demand. The tiles drawn are
+those of the level for the scale of the cairo context that intersect the
+area drawn. They and a ring of tiles around them form the view, which is
+read on the image decode threads and kept resident. One read of the image
+runs at a time. It reads every tile of the view that is not resident at
+once, so a png is decoded once for all of the columns, and it continues
+with the tiles requested meanwhile. While a tile is read, a
+resident tile of a nearby level is scaled in its place. When the tiles
+exceed the memory budget, those outside of the view that were drawn least
+recently are released. fn_ready is called when the image is opened and when
+tiles are read, with false when the image could not be read.
+*/
+class image_tiles_t : public std::enable_shared_from_this<image_tiles_t> {
+public:
+  typedef std::shared_ptr<image_tiles_t> image_tiles_ptr_t;
+  typedef std::function<void(bool bRead)> tiles_ready_t;
+
+  image_tiles_t(const std::string &_data, const tiles_ready_t &_fn_ready)
+      : data(_data), fn_ready(_fn_ready) {}
+  image_tiles_t(const image_tiles_t &other) = delete;
+  image_tiles_t &operator=(const image_tiles_t &other) = delete;
+  ~image_tiles_t();
+
+  bool draw(cairo_t *cr, double x, double y, double scale,
+            const cairo_rectangle_t &area,
+            cairo_filter_t filter = CAIRO_FILTER_GOOD);
+  std::array<int, 2> size(void);
+
+  static constexpr int prefetch = 1;
+  static constexpr std::size_t budget = 64 * 1024 * 1024;
+
+private:
+  class tile_t {
+  public:
+    // nullptr while the tile is read.
+    cairo_surface_t *surface = nullptr;
+    std::size_t stamp = {};
+  };
+
+  int level(double pixels) const;
+  int top_level(void) const;
+  bool in_view(const image_tile_key_t &key) const;
+  cairo_surface_t *resident(const image_tile_key_t &key);
+  void paint(cairo_t *cr, double x, double y, double scale,
+             const image_tile_key_t &key, cairo_surface_t *surface,
+             const cairo_rectangle_t &clip, cairo_filter_t filter);
+  void read(void);
+  void trim(void);
+
+  std::string data = {};
+  tiles_ready_t fn_ready = {};
+
+  std::mutex lock = {};
+  std::unique_ptr<image_tile_source_t> source = {};
+  bool opening = {};
+  bool opened = {};
+  bool bFailed = {};
+  // a read of the tiles is queued or running.
+  bool reading = {};
+  std::unordered_map<image_tile_key_t, tile_t> tiles = {};
+  std::size_t bytes = {};
+  std::size_t stamp = {};
+  int view_level = {};
+  cairo_rectangle_int_t view = {};
+};
+
+/// @brief surfaces with at least this many pixels are blurred by several
+/// threads.
+constexpr std::size_t blur_parallel_pixels = 256 * 256;
+
+void set_blur_options(blur_engine_t engine, blur_quality_t quality);
+blur_engine_t select_blur_engine(unsigned int radius, int width, int height);
 void blur_image(cairo_surface_t *img, unsigned int radius);
+void blur_image(cairo_surface_t *img, unsigned int radius,
+                blur_engine_t engine);
+void stack_blur_scalar(cairo_surface_t *img, unsigned int radius);
 
-#elif defined(USE_SVGREN)
-cairo_surface_t *blur_image(cairo_surface_t *img, unsigned int radius);
+cairo_surface_t *shadow_mask(int width, int height,
+                             const std::function<void(cairo_t *cr)> &fn_shape,
+                             unsigned int radius = 0);
 
 cairo_surface_t *cairoImageSurfaceBlur(cairo_surface_t *img,
                                        std::array<double, 2> stdDeviation);
 void boxBlurHorizontal(std::uint8_t *dst, const std::uint8_t *src,
                        unsigned dstStride, unsigned srcStride, unsigned width,
                        unsigned height, unsigned boxSize, unsigned boxOffset,
-                       unsigned channel);
+                       unsigned channel,
+                       unsigned pixelSize = sizeof(std::uint32_t));
 void boxBlurVertical(std::uint8_t *dst, const std::uint8_t *src,
                      unsigned dstStride, unsigned srcStride, unsigned width,
                      unsigned height, unsigned boxSize, unsigned boxOffset,
-                     unsigned channel);
-
-#endif // defined
+                     unsigned channel,
+                     unsigned pixelSize = sizeof(std::uint32_t));
 
 } // namespace uxdevice
@@ -62,6 +62,7 @@ void uxdevice::surface_area_t::render_loop(void) {
     // search these for unready and syncs display context
     // if no work exists  it waits on the cvRenderWork condition variable.
     if (context.surface_prime()) {
+      merge_command_buffers();
       context.render();
     }
 
@@ -86,10 +87,14 @@ necessary operation.
 */
 void uxdevice::surface_area_t::dispatch_event(const event_t &evt) {
 
-  if (evt.type == std::type_index(typeid(listen_paint_t)))
+  if (evt.type == std::type_index(typeid(listen_paint_t))) {
     context.state_surface(evt.x, evt.y, evt.w, evt.h);
-  else if (evt.type == std::type_index(typeid(listen_resize_t)))
+  } else if (evt.type == std::type_index(typeid(listen_resize_t))) {
+    context.interaction();
     context.resize_surface(evt.w, evt.h);
+  } else if (evt.type == std::type_index(typeid(listen_wheel_t))) {
+    context.interaction();
+  }
 
   if (fnEvents)
     fnEvents(evt);
@@ -306,9 +311,13 @@ uxdevice::surface_area_t::~surface_area_t(void) { close_window(); }
 
 /**
   \internal
-  \brief sets the defaults for the context. font, colors, etc.
+  \brief sets the defaults for the context. font, colors, etc. The attributes
+  are kept as the starting attributes of command buffers.
 */
-void surface_area_t::set_surface_defaults(void) { SYSTEM_DEFAULTS }
+void surface_area_t::set_surface_defaults(void) {
+  SYSTEM_DEFAULTS
+  default_attributes.copy_unit_memory(context);
+}
 
 /**
 \brief API interface, just data is passed to objects. Objects are
@@ -325,10 +334,294 @@ is not cleared.  The display and all objects are released.
 */
 
 void uxdevice::surface_area_t::clear(void) {
+  group_stack.clear();
+  recorded_path.reset();
   context.clear();
   display_list_clear();
 }
 
+/**
+\fn prewarm_fonts
+\param const std::vector<std::string> &descriptions
+\brief parses and loads the fonts on a background thread so that their first
+use by text does not wait upon fontconfig. Returns at once.
+*/
+surface_area_t &uxdevice::surface_area_t::prewarm_fonts(
+    const std::vector<std::string> &descriptions) {
+  font_registry_t::prewarm(descriptions);
+  return *this;
+}
+
+/**
+\fn blur
+\param blur_engine_t engine
+\param blur_quality_t quality
+\brief selects the blur of shadows. With blur_engine_t::automatic the engine
+is chosen for each shadow by its radius and size under the quality. The
+cached shadows are released so shadows created afterwards use the engine.
+*/
+surface_area_t &uxdevice::surface_area_t::blur(blur_engine_t engine,
+                                               blur_quality_t quality) {
+  set_blur_options(engine, quality);
+  text_shadow_cache_t::clear();
+  return *this;
+}
+
+/**
+\fn progressive
+\param bool bEnabled
+\brief while enabled, frames drawn during a resize, a scroll or an animation
+use fast antialiasing and image filters and a coarser tolerance. Once
+interaction has been idle briefly, the area drawn so is drawn again at full
+quality. Resizes and wheel events are interactions. An application notes
+others, such as frames of an animation, with interaction().
+*/
+surface_area_t &uxdevice::surface_area_t::progressive(bool bEnabled) {
+  context.progressive = bEnabled;
+  return *this;
+}
+
+/**
+\fn interaction
+\brief notes an interaction, such as a frame of an animation or a drag, so
+that frames are drawn at interactive quality until it is idle.
+*/
+surface_area_t &uxdevice::surface_area_t::interaction(void) {
+  context.interaction();
+  return *this;
+}
+
+/**
+\fn measure
+\param const text_measure_t &request
+\brief returns the extents of the text as it would be laid out if inserted
+with the current options of the surface. Nothing is drawn. The text is
+shaped on the calling thread.
+*/
+text_extents_t
+uxdevice::surface_area_t::measure(const text_measure_t &request) {
+  return measure(std::vector<text_measure_t>{request}).front();
+}
+
+/**
+\fn measure
+\param const std::vector<text_measure_t> &requests
+\brief returns the extents of each text in the order requested. The texts
+are shaped as they would be for drawing and the layouts are held by the text
+layout cache, so text inserted after it is measured is not shaped again.
+Large batches are shaped in parallel by the shaping threads. Texts are
+measured as empty when there is no font.
+*/
+std::vector<text_extents_t>
+uxdevice::surface_area_t::measure(const std::vector<text_measure_t> &requests) {
+  std::vector<text_extents_t> extents(requests.size());
+
+  // the memory of each text is the current options with the request applied.
+  std::vector<unit_memory_storage_t> memory(requests.size());
+  std::vector<text_layout_key_t> keys(requests.size());
+  for (std::size_t i = 0; i < requests.size(); i++) {
+    auto &request = requests[i];
+    auto &m = memory[i];
+    m.copy_unit_memory(context);
+    m.unit_memory<text_data_t>(std::make_shared<text_data_t>(request.text));
+    if (!request.font_description.empty())
+      m.unit_memory<text_font_t>(
+          std::make_shared<text_font_t>(request.font_description));
+    m.unit_memory<coordinate_t>(std::make_shared<coordinate_t>(
+        0, 0, request.width > 0 ? request.width : -1,
+        request.height > 0 ? request.height : -1));
+    if (request.ellipsize)
+      m.unit_memory<text_ellipsize_t>(
+          std::make_shared<text_ellipsize_t>(*request.ellipsize));
+
+    if (m.unit_memory<text_font_t>())
+      keys[i] = textual_render_storage_t::text_layout_key(m);
+  }
+
+  auto fn_extents = [](const text_layout_cache_t::text_layout_ptr_t &shaped) {
+    return text_extents_t{shaped->ink_rect, shaped->logical_rect,
+                          shaped->line_count};
+  };
+
+  if (requests.size() < measure_parallel_batch) {
+    for (std::size_t i = 0; i < requests.size(); i++) {
+      if (!memory[i].unit_memory<text_font_t>())
+        continue;
+      auto &m = memory[i];
+      extents[i] = fn_extents(text_layout_cache_t::acquire(
+          keys[i], [&](PangoLayout *l) {
+            textual_render_storage_t::layout_text(m, l);
+          }));
+    }
+    return extents;
+  }
+
+  std::vector<text_layout_cache_t::text_layout_future_t> shaped(
+      requests.size());
+  for (std::size_t i = 0; i < requests.size(); i++) {
+    if (!memory[i].unit_memory<text_font_t>())
+      continue;
+    shaped[i] = text_layout_cache_t::acquire_async(
+        keys[i], [m = memory[i]](PangoLayout *l) {
+          textual_render_storage_t::layout_text(m, l);
+        });
+  }
+
+  for (std::size_t i = 0; i < requests.size(); i++)
+    if (shaped[i].valid())
+      extents[i] = fn_extents(shaped[i].get());
+
+  return extents;
+}
+
+/**
+\fn group_begin(const std::string &_name)
+\param const std::string &_name
+
+\brief opens the named group. Drawing objects inserted afterwards become
+members of the group until group_end() is called. If the group exists, it is
+reopened and the objects are appended. Groups may be nested.
+
+\details The group renders its members into a cached layer surface. The
+group_t returned by group(const std::string &) provides move, opacity, hide
+and show which only recomposite the layer.
+*/
+surface_area_t &
+uxdevice::surface_area_t::group_begin(const std::string &_name) {
+  std::shared_ptr<group_t> obj = {};
+
+  auto n = mapped_objects.find(indirect_index_display_unit_t{_name});
+  if (n != mapped_objects.end())
+    obj = std::dynamic_pointer_cast<group_t>(n->second);
+
+  if (!obj) {
+    obj = std::make_shared<group_t>();
+    obj->index(_name);
+    display_list<group_t>(obj);
+    maintain_index(obj);
+    obj->emit(context);
+  }
+
+  group_stack.emplace_back(obj);
+  return *this;
+}
+
+/**
+\fn group_end(void)
+
+\brief closes the most recently opened group. The bounds are computed from
+the members. A new group is added to the parent group or to the context. A
+reopened group requests a repaint of its area in surface coordinates, which
+includes the offsets of its parent groups.
+*/
+surface_area_t &uxdevice::surface_area_t::group_end(void) {
+  if (group_stack.empty())
+    return *this;
+
+  std::shared_ptr<group_t> obj = group_stack.back();
+  group_stack.pop_back();
+
+  obj->functors_lock(true);
+  obj->update_bounds();
+  obj->functors_lock(false);
+
+  if (obj->viewport_inked) {
+    obj->changed();
+    obj->damage();
+  } else {
+    add_drawable(obj);
+  }
+
+  return *this;
+}
+
+/**
+\fn command_buffer(std::size_t order)
+\param std::size_t order - the key of the buffer and its position when
+merged.
+
+\brief returns the command buffer for the given key, creating it when it does
+not exist. Each producer thread should use its own key. The buffers are merged
+into the display list in ascending key order at the start of a frame so the
+result does not depend upon thread timing.
+*/
+command_buffer_t &uxdevice::surface_area_t::command_buffer(std::size_t order) {
+  COMMAND_BUFFERS_SPIN;
+  auto &ptr = command_buffers[order];
+  if (!ptr) {
+    ptr = std::make_shared<command_buffer_t>();
+    ptr->attributes.copy_unit_memory(default_attributes);
+    ptr->fnSubmitted = [this]() { context.state_notify_complete(); };
+  }
+  command_buffer_t &ret = *ptr;
+  COMMAND_BUFFERS_CLEAR;
+  return ret;
+}
+
+/**
+\fn recording(bool b)
+\param bool b - true to begin recording, false to emit directly.
+
+\brief selects whether path, line attribute and painting units are emitted
+upon insertion or recorded. While recording, the units are captured into a
+recorded_path_t that is completed by a stroke, fill or paint unit. The
+recorded path has computed extents and is drawn by the render thread, so it
+is culled and cached as other drawing objects. The calling thread does not
+use the surface cairo context. An incomplete path is discarded when
+recording is turned off.
+*/
+surface_area_t &uxdevice::surface_area_t::recording(bool b) {
+  bRecording = b;
+  if (!bRecording)
+    recorded_path.reset();
+  return *this;
+}
+
+/**
+\internal
+\brief inserts the submitted commands of each command buffer on the render
+thread. The attribute memory of the buffer is selected for the render thread
+while its commands are inserted, so the attribute memory of the context, which
+the application thread streams into, is not read or changed.
+*/
+void uxdevice::surface_area_t::merge_command_buffers(void) {
+  COMMAND_BUFFERS_SPIN;
+  if (command_buffers.empty()) {
+    COMMAND_BUFFERS_CLEAR;
+    return;
+  }
+  std::list<std::shared_ptr<command_buffer_t>> buffers = {};
+  for (auto &n : command_buffers)
+    buffers.emplace_back(n.second);
+  COMMAND_BUFFERS_CLEAR;
+
+  for (auto &buffer : buffers) {
+    command_buffer_t::command_list_t commands = buffer->acquire();
+    if (commands.empty())
+      continue;
+
+    context.attributes(&buffer->attributes);
+    merging_buffer = buffer.get();
+    for (auto &fn : commands)
+      fn(*this);
+    merging_buffer = nullptr;
+    context.attributes(nullptr);
+  }
+}
+
+/**
+\internal
+\brief places the drawing object within the currently open group or the
+context when no group is open.
+*/
+void uxdevice::surface_area_t::add_drawable(
+    std::shared_ptr<drawing_output_t> obj) {
+  if (group_stack.empty())
+    context.add_drawable(obj);
+  else
+    group_stack.back()->add_drawable(obj);
+}
+
 /**
 \fn notify_complete(void)
 
@@ -345,21 +638,6 @@ void uxdevice::surface_area_t::notify_complete(void) {
   context.state_notify_complete();
 }
 
-/**
-\brief called by each of the display unit objects to index the item if a key
-exists. A key can be given as a text_data_t or an integer. The [] operator is
-used to access the data.
-*/
-void uxdevice::surface_area_t::maintain_index(
-    const std::shared_ptr<display_unit_t> obj) {
-  std::shared_ptr<key_storage_t> key_store =
-      std::dynamic_pointer_cast<key_storage_t>(obj);
-
-  if (!std::holds_alternative<std::monostate>(key_store->key))
-    mapped_objects[key_store->key] = obj;
-  return;
-}
-
 /**
 \internal
 \fn stream input
@@ -847,6 +1125,9 @@ void uxdevice::surface_area_t::open_window(
   context.window_height = *it;
   context.brush = background;
 
+  // fontconfig is loaded while the connection and window are created.
+  font_registry_t::prewarm({DEFAULT_FONT_DESCRIPTION});
+
   // this open provides interoperability between xcb and xwindows
   // this is used here because of the necessity of key mapping.
   context.xdisplay = XOpenDisplay(nullptr);
@@ -45,6 +45,13 @@ options when compiling the text_color_t.
 #define DEFAULT_WINDOW_TITLE                                                   \
   std::string(__FILE__) + std::string("  ") + std::string(__DATE__)
 
+/**
+\internal
+\def DEFAULT_FONT_DESCRIPTION
+\brief the font of a new window. It is prewarmed while the window opens.
+*/
+#define DEFAULT_FONT_DESCRIPTION "Arial 20px"
+
 /**
 \internal
 \def SYSTEM_DEFAULTS
@@ -53,7 +60,7 @@ options when compiling the text_color_t.
 */
 #define SYSTEM_DEFAULTS                                                        \
   in(absolute_coordinate_t(), text_render_normal_t{},                          \
-     text_font_t{"Arial 20px"}, text_color_t{"black"},                         \
+     text_font_t{DEFAULT_FONT_DESCRIPTION}, text_color_t{"black"},             \
      surface_area_brush_t{"white"}, text_indent_t{100.0},                      \
      text_alignment_t{text_alignment_options_t::left},                         \
      text_ellipsize_t{text_ellipsize_options_t::off}, text_line_space_t{1.0},  \
@@ -61,29 +68,6 @@ options when compiling the text_color_t.
          std::vector<double>{250, 250, 250, 250, 250, 250, 250, 250}},         \
      surface_area_title_t{DEFAULT_WINDOW_TITLE});
 
-/**
-\def USE_STACKBLUR
-\brief The stack blue algorithm of shadow creation is used. Use either
- USE_STACKBLUR or USE_SVGREN. Both cannot be used at the same time.
-*/
-#define USE_STACKBLUR
-
-/**
-\def USE_SVGREN
-\brief The svgren svg c++ algorithm of image blurring is used. A convolution
-matrix is applied. Much slower but may look a bit better. Use either
- USE_STACKBLUR or USE_SVGREN. Both cannot be used at the same time.
-*/
-
-//#define USE_SVGREN
-
-// catch for dual defines. must comment out one of the options.
-#ifdef USE_STACKBLUR
-#ifdef USE_SVGREN
-#error "Select either USE_STACKBLUR or USE_SVGREN but not both."
-#endif // USE_SVGREN
-#endif
-
 /**
 \def USE_DEBUG_CONSOLE
 */
@@ -97,6 +81,7 @@ matrix is applied. Much slower but may look a bit better. Use either
 #include "uxevent.hpp"
 #include "uxmatrix.hpp"
 #include "uxpaint.hpp"
+#include "uxtextlayout.hpp"
 
 #include "uxdisplaycontext.hpp"
 #include "uxdisplayunitbase.hpp"
@@ -162,6 +147,113 @@ varying pairs may be given. two or four.
 */
 typedef std::list<short int> coordinate_list_t;
 
+/**
+\internal
+\struct unit_traits_t
+\tparam T - the type inserted into the stream.
+\brief the characteristics of a unit type used by the stream insertion
+operator. Computed once per type at compile time so the insertion of a unit
+is specialized without any run time type queries.
+*/
+template <typename T> struct unit_traits_t {
+  static constexpr bool is_listener = std::is_base_of<listener_t<T>, T>::value;
+  static constexpr bool is_display_unit =
+      std::is_base_of<display_unit_t, T>::value;
+  static constexpr bool is_indexed = std::is_base_of<key_storage_t, T>::value;
+  static constexpr bool is_attribute =
+      std::is_base_of<attribute_display_context_memory_t, T>::value;
+  static constexpr bool emits_context =
+      std::is_base_of<emit_display_context_abstract_t, T>::value;
+  static constexpr bool emits_cairo =
+      std::is_base_of<emit_cairo_abstract_t, T>::value;
+  static constexpr bool emits_cairo_relative =
+      std::is_base_of<emit_cairo_relative_coordinate_abstract_t, T>::value;
+  static constexpr bool paints_path =
+      std::is_base_of<path_paint_abstract_t, T>::value;
+  static constexpr bool is_drawing_output =
+      std::is_base_of<drawing_output_t, T>::value;
+};
+
+/**
+\class command_buffer_t
+
+\brief A recording of stream insertions made by one producer thread. The
+buffer is obtained from surface_area_t::command_buffer(order) and filled with
+the same stream syntax as the surface. Recorded commands become visible to the
+renderer when submit() is called. At the start of the next frame the submitted
+buffers are merged into the display list in ascending order of their key, each
+one inserted using its own attribute memory, which starts from the surface
+defaults. Several threads may therefore stream into separate buffers at once
+without disturbing each other's text color, font, coordinate and similar
+attributes. Path units are recorded into a path held by the buffer, which a
+stroke, fill or paint completes, so the render thread does not draw them on
+the surface context. Groups opened on the surface do not apply to buffered
+units, and buffered units are not indexed by key.
+
+*/
+class surface_area_t;
+class command_buffer_t {
+public:
+  typedef std::function<void(surface_area_t &vis)> command_t;
+  typedef std::list<command_t> command_list_t;
+
+  command_buffer_t() {}
+  virtual ~command_buffer_t() {}
+
+  std::atomic_flag lockCommands = ATOMIC_FLAG_INIT;
+#define COMMAND_BUFFER_SPIN                                                    \
+  while (lockCommands.test_and_set(std::memory_order_acquire))
+#define COMMAND_BUFFER_CLEAR lockCommands.clear(std::memory_order_release)
+
+  template <typename T> command_buffer_t &operator<<(const T &data) {
+    COMMAND_BUFFER_SPIN;
+    recording.emplace_back([data](auto &vis) { vis.buffer_input(data); });
+    COMMAND_BUFFER_CLEAR;
+    return *this;
+  }
+
+  /// @brief records the objects as a single command.
+  template <typename... Args> void in(const Args &... args) {
+    COMMAND_BUFFER_SPIN;
+    recording.emplace_back(
+        [args...](auto &vis) { (vis.buffer_input(args), ...); });
+    COMMAND_BUFFER_CLEAR;
+  }
+
+  /// @brief publishes the recorded commands for the next frame merge and
+  /// wakes the renderer.
+  void submit(void) {
+    COMMAND_BUFFER_SPIN;
+    submitted.splice(submitted.end(), recording);
+    COMMAND_BUFFER_CLEAR;
+    if (fnSubmitted)
+      fnSubmitted();
+  }
+
+  /// @brief removes the submitted commands. Called by the renderer.
+  command_list_t acquire(void) {
+    command_list_t ret = {};
+    COMMAND_BUFFER_SPIN;
+    ret.swap(submitted);
+    COMMAND_BUFFER_CLEAR;
+    return ret;
+  }
+
+  // attribute memory of the buffer, only used by the render thread.
+  unit_memory_storage_t attributes = {};
+
+  // the path being recorded from the buffered path units, only used by the
+  // render thread.
+  std::shared_ptr<recorded_path_t> path = {};
+
+  // called after submit(), set by the surface to wake its renderer.
+  std::function<void(void)> fnSubmitted = nullptr;
+
+private:
+  command_list_t recording = {};
+  command_list_t submitted = {};
+};
+
 /**
 \class surface_area_t
 
@@ -242,42 +334,13 @@ public:
 
   */
   template <typename T> surface_area_t &operator<<(const T &data) {
-    // event listeners are intercepted here.
-    if constexpr (std::is_base_of<listener_t<T>, T>::value) {
-
-    } else if constexpr (std::is_base_of<display_unit_t, T>::value) {
-      std::shared_ptr<T> obj = display_list<T>(data);
-      maintain_index(std::dynamic_pointer_cast<display_unit_t>(obj));
-
-      if constexpr (std::is_base_of<attribute_display_context_memory_t,
-                                    T>::value)
-        context.unit_memory<T>(obj);
-
-      if constexpr (std::is_base_of<emit_display_context_abstract_t, T>::value)
-        obj->emit(context);
-
-      if constexpr (std::is_base_of<emit_cairo_abstract_t, T>::value)
-        obj->emit(context.cr);
+    using traits = unit_traits_t<T>;
 
-      if constexpr (std::is_base_of<emit_cairo_relative_coordinate_abstract_t,
-                                    T>::value) {
-        if (context.unit_memory<relative_coordinate_t>())
-          obj->emit_relative(context.cr);
-        else
-          obj->emit_absolute(context.cr);
-      }
-
-      if constexpr (std::is_base_of<emit_cairo_coordinate_abstract_t,
-                                    T>::value) {
-      }
-      // virtual void emit(cairo_t *cr) = 0;
-      // virtual void emit(cairo_t *cr, const coordinate_t &a) = 0;
-      if constexpr (std::is_base_of<emit_pango_abstract_t, T>::value) {
-      }
+    // event listeners are intercepted here.
+    if constexpr (traits::is_listener) {
 
-      // if the item is a drawing output object, inform the context of it.
-      if constexpr (std::is_base_of<drawing_output_t, T>::value)
-        context.add_drawable(obj);
+    } else if constexpr (traits::is_display_unit) {
+      insert_display_unit<T>(display_list<T>(data));
 
       // otherwise the input is another type. Try
       // the default string stream.
@@ -293,53 +356,87 @@ public:
 
   /**
   \fn operator<<
-  \brief
+  \brief inserts a unit held by the caller. The unit is placed on the display
+  list as is and then processed as one inserted by value, so it is recorded
+  while a path is being recorded and becomes a member of an open group.
 
   */
   template <typename T>
   surface_area_t &operator<<(const std::shared_ptr<T> data) {
+    using traits = unit_traits_t<T>;
 
     // if the item is an event listener it is placed into a separate area.
-    if constexpr (std::is_base_of<listener_t<T>, T>::value) {
+    if constexpr (traits::is_listener) {
 
-      // display units are handled distinctly
-    } else if constexpr (std::is_base_of<display_unit_t, T>::value) {
-      display_list<T>(data);
-      maintain_index(data);
+    } else if constexpr (traits::is_display_unit) {
+      insert_display_unit<T>(display_list<T>(data));
 
-      if constexpr (std::is_base_of<attribute_display_context_memory_t,
-                                    T>::value)
-        context.unit_memory<T>(data);
+      // otherwise the input is another type. Try
+      // the default string stream.
+    } else {
+      stream_input(data);
+    }
 
-      if constexpr (std::is_base_of<emit_display_context_abstract_t, T>::value)
-        T::emit(context);
+    return *this;
+  }
 
-      if constexpr (std::is_base_of<emit_cairo_abstract_t, T>::value)
-        T::emit(context.cr);
+  /**
+  \fn buffer_input
+  \brief inserts a unit recorded by a command buffer. Called by the render
+  thread within merge_command_buffers while the attribute memory of the buffer
+  is selected. The unit is placed on the display list and drawing objects are
+  given to the context directly, so the groups, index and path recording of
+  the application thread are not touched. Path units are recorded into the
+  path of the buffer rather than emitted to the surface context.
+  */
+  template <typename T> void buffer_input(const T &data) {
+    using traits = unit_traits_t<T>;
 
-      if constexpr (std::is_base_of<emit_cairo_relative_coordinate_abstract_t,
-                                    T>::value) {
-        if (context.unit_memory<relative_coordinate_t>())
-          T::emit_relative(context.cr);
+    if constexpr (traits::is_listener) {
+
+    } else if constexpr (traits::is_display_unit) {
+      std::shared_ptr<T> obj = display_list<T>(data);
+
+      if constexpr (traits::is_attribute)
+        context.unit_memory<T>(obj);
+
+      if constexpr (traits::emits_context)
+        obj->emit(context);
+
+      std::shared_ptr<recorded_path_t> &path = merging_buffer->path;
+      bool brecorded = false;
+
+      if constexpr (traits::emits_cairo) {
+        // a stroke, fill or paint completes the recorded path.
+        if constexpr (traits::paints_path)
+          context.add_drawable(record_paint(path, obj));
         else
-          T::emit_absolute(context.cr);
+          record(path, obj, [obj](cairo_t *cr) { obj->emit(cr); });
+        brecorded = true;
       }
 
-      if constexpr (std::is_base_of<emit_cairo_coordinate_abstract_t,
-                                    T>::value) {
-      }
-      // virtual void emit(cairo_t *cr) = 0;
-      // virtual void emit(cairo_t *cr, const coordinate_t &a) = 0;
-      if constexpr (std::is_base_of<emit_pango_abstract_t, T>::value) {
+      if constexpr (traits::emits_cairo_relative) {
+        if (context.unit_memory<relative_coordinate_t>())
+          record(path, obj, [obj](cairo_t *cr) { obj->emit_relative(cr); });
+        else
+          record(path, obj, [obj](cairo_t *cr) { obj->emit_absolute(cr); });
+        brecorded = true;
       }
 
-      // otherwise the input is another type. Try
-      // the default string stream.
+      if constexpr (traits::is_drawing_output)
+        if (!brecorded)
+          context.add_drawable(obj);
+
+    } else if constexpr (std::is_same<T, std::shared_ptr<std::string>>::value) {
+      buffer_input(text_data_t{data});
+      buffer_input(textual_render_t{});
+
     } else {
-      stream_input(data);
+      std::ostringstream s;
+      s << data;
+      buffer_input(text_data_t{s.str()});
+      buffer_input(textual_render_t{});
     }
-
-    return *this;
   }
 
   /*
@@ -375,11 +472,8 @@ public:
         vis.in(text_font_t{"Arial 20px"}, coordindate_t{0,0}, "Hello");
   */
 public:
-  template <typename T> void in(const T &obj) { operator<<(obj); }
-  template <typename T, typename... Args>
-  void in(const T &obj, const Args &... args) {
-    operator<<(obj);
-    in(args...);
+  template <typename... Args> void in(const Args &... args) {
+    (operator<<(args), ...);
   }
 
 public:
@@ -420,18 +514,38 @@ public:
     return *_val;
   }
 
-  display_unit_t &group(const std::string &sgroupname) {
-    auto n = mapped_objects.find(sgroupname);
-    return *n->second;
+  /// @brief returns the named group, or nullptr when no group has the name.
+  group_t *group(const std::string &sgroupname) {
+    auto n = mapped_objects.find(indirect_index_display_unit_t{sgroupname});
+    if (n == mapped_objects.end())
+      return nullptr;
+    return dynamic_cast<group_t *>(n->second.get());
   }
 
   bool processing(void) { return bProcessing; };
-  surface_area_t &group(std::string &_name);
+  surface_area_t &group_begin(const std::string &_name);
+  surface_area_t &group_end(void);
+
+  command_buffer_t &command_buffer(std::size_t order);
+
+  surface_area_t &recording(bool b);
 
   surface_area_t &device_offset(double x, double y);
   surface_area_t &device_scale(double x, double y);
   void clear(void);
   void notify_complete(void);
+  surface_area_t &prewarm_fonts(const std::vector<std::string> &descriptions);
+  surface_area_t &blur(blur_engine_t engine,
+                       blur_quality_t quality = blur_quality_t::good);
+  surface_area_t &progressive(bool bEnabled);
+  surface_area_t &interaction(void);
+
+  text_extents_t measure(const text_measure_t &request);
+  std::vector<text_extents_t>
+  measure(const std::vector<text_measure_t> &requests);
+
+  /// @brief batches of at least this size are shaped by the shaping threads.
+  static constexpr std::size_t measure_parallel_batch = 16;
 
   surface_area_t &save(void);
   surface_area_t &restore(void);
@@ -472,7 +586,22 @@ private:
   void close_window(void);
   void set_surface_defaults(void);
   bool relative_coordinate = false;
-  void maintain_index(const std::shared_ptr<display_unit_t> obj);
+
+  /**
+  \brief called by each of the display unit objects to index the item if a
+  key exists. A key can be given as a text_data_t or an integer. The []
+  operator is used to access the data. The key is read through the static
+  base class so no run time cast occurs.
+  */
+  template <typename T> void maintain_index(const std::shared_ptr<T> &obj) {
+    if constexpr (unit_traits_t<T>::is_indexed) {
+      const key_storage_t &key_store = *obj;
+      if (!std::holds_alternative<std::monostate>(key_store.key))
+        mapped_objects[key_store.key] = obj;
+    }
+  }
+  void add_drawable(std::shared_ptr<drawing_output_t> obj);
+  void merge_command_buffers(void);
 
 private:
   display_context_t context = display_context_t();
@@ -519,6 +648,128 @@ private:
                      std::shared_ptr<display_unit_t>>
       mapped_objects = {};
 
+  // groups opened by group_begin() and not yet closed by group_end().
+  std::list<std::shared_ptr<group_t>> group_stack = {};
+
+  // path recording, cairo units are captured rather than emitted.
+  bool bRecording = false;
+  std::shared_ptr<recorded_path_t> recorded_path = {};
+
+  // the command buffer being merged, only used by the render thread.
+  command_buffer_t *merging_buffer = nullptr;
+
+  /// @brief appends the cairo call of a path or attribute unit to the
+  /// path being recorded.
+  template <typename T>
+  void record(std::shared_ptr<recorded_path_t> &path,
+              const std::shared_ptr<T> obj, const cairo_function_t &fn) {
+    if (!path)
+      path = std::make_shared<recorded_path_t>();
+    path->commands.emplace_back(fn);
+    hash_combine(path->recorded_hash, obj->hash_code());
+  }
+
+  /// @brief completes the recorded path with the painting unit. The extents
+  /// are computed and the path is placed on the display list. The completed
+  /// path is returned to be added as a drawing object.
+  template <typename T>
+  std::shared_ptr<recorded_path_t>
+  record_paint(std::shared_ptr<recorded_path_t> &path,
+               const std::shared_ptr<T> obj) {
+    if (!path)
+      path = std::make_shared<recorded_path_t>();
+    path->paint = [obj](cairo_t *cr) { obj->emit(cr); };
+    path->extents = [obj](cairo_t *cr, cairo_rectangle_t &r) {
+      return obj->path_extents(cr, r);
+    };
+    hash_combine(path->recorded_hash, obj->hash_code());
+
+    std::shared_ptr<recorded_path_t> completed = path;
+    path.reset();
+
+    display_list<recorded_path_t>(completed);
+    completed->emit(context);
+    return completed;
+  }
+
+  /// @brief processes a display unit placed on the display list according to
+  /// its traits. Units are indexed, attributes are stored within the context
+  /// memory and cairo units are emitted or recorded. Drawing objects are
+  /// added to the open group or to the context.
+  template <typename T>
+  void insert_display_unit(const std::shared_ptr<T> obj) {
+    using traits = unit_traits_t<T>;
+
+    maintain_index(obj);
+
+    if constexpr (traits::is_attribute)
+      context.unit_memory<T>(obj);
+
+    if constexpr (traits::emits_context)
+      obj->emit(context);
+
+    // when recording, the cairo calls are captured into a recorded_path_t
+    // and issued later by the render thread.
+    bool brecorded = false;
+
+    if constexpr (traits::emits_cairo) {
+      if (bRecording) {
+        // a stroke, fill or paint completes the recorded path.
+        if constexpr (traits::paints_path)
+          add_drawable(record_paint(recorded_path, obj));
+        else
+          record(recorded_path, obj, [obj](cairo_t *cr) { obj->emit(cr); });
+        brecorded = true;
+      } else {
+        obj->emit(context.cr);
+      }
+    }
+
+    if constexpr (traits::emits_cairo_relative) {
+      if (bRecording) {
+        if (context.unit_memory<relative_coordinate_t>())
+          record(recorded_path, obj,
+                 [obj](cairo_t *cr) { obj->emit_relative(cr); });
+        else
+          record(recorded_path, obj,
+                 [obj](cairo_t *cr) { obj->emit_absolute(cr); });
+        brecorded = true;
+      } else if (context.unit_memory<relative_coordinate_t>()) {
+        obj->emit_relative(context.cr);
+      } else {
+        obj->emit_absolute(context.cr);
+      }
+    }
+
+    if constexpr (std::is_base_of<emit_cairo_coordinate_abstract_t,
+                                  T>::value) {
+    }
+    // virtual void emit(cairo_t *cr) = 0;
+    // virtual void emit(cairo_t *cr, const coordinate_t &a) = 0;
+    if constexpr (std::is_base_of<emit_pango_abstract_t, T>::value) {
+    }
+
+    // if the item is a drawing output object, inform the context of it.
+    // when a group is open, the object becomes a member of the group.
+    // recorded objects are drawn by the recorded_path_t.
+    if constexpr (traits::is_drawing_output)
+      if (!brecorded)
+        add_drawable(obj);
+  }
+
+  // the attribute memory after the surface defaults are set, the starting
+  // attributes of a command buffer.
+  unit_memory_storage_t default_attributes = {};
+
+  // producer command buffers, the key is the merge order.
+  std::map<std::size_t, std::shared_ptr<command_buffer_t>> command_buffers =
+      {};
+  std::atomic_flag lockCommandBuffers = ATOMIC_FLAG_INIT;
+#define COMMAND_BUFFERS_SPIN                                                   \
+  while (lockCommandBuffers.test_and_set(std::memory_order_acquire))
+#define COMMAND_BUFFERS_CLEAR                                                  \
+  lockCommandBuffers.clear(std::memory_order_release)
+
   std::list<event_handler_t> onfocus = {};
   std::list<event_handler_t> onblur = {};
   std::list<event_handler_t> onresize = {};
@@ -61,13 +61,25 @@ bool uxdevice::display_context_t::surface_prime() {
   if (bRet)
     return bRet;
 
+  // the area drawn during interaction is drawn again once it is idle.
+  if (refine())
+    return true;
+
   // wait for render work if none has already been provided.
   // the state routines could easily produce region rectangular information
   // along the notification but do not. The user should call notify_complete.
+  // While a refinement is pending, the wait ends when interaction is idle.
   if (!bRet) {
     std::unique_lock<std::mutex> lk(mutexRenderWork);
-    cvRenderWork.wait(lk);
+    if (refine_region) {
+      std::chrono::steady_clock::time_point idle(
+          std::chrono::steady_clock::duration(last_interaction.load()));
+      cvRenderWork.wait_until(lk, idle + refine_delay);
+    } else {
+      cvRenderWork.wait(lk);
+    }
     lk.unlock();
+    refine();
     bRet = true;
   }
 
@@ -167,11 +179,15 @@ void uxdevice::display_context_t::render(void) {
 
   apply_surface_requests();
 
+  // frames drawn during interaction are drawn at interactive quality.
+  bInteractiveFrame = interactive();
+
   // partitionVisibility();
 
-  // detect any changes that have occurred
+  // detect any changes that have occurred. objects that know the areas
+  // changed state only those.
   for (auto n : viewport_on)
-    if (n->has_changed())
+    if (n->has_changed() && !n->state_damage(*this))
       state(n);
 
   REGIONS_SPIN;
@@ -199,6 +215,10 @@ void uxdevice::display_context_t::render(void) {
     // are distinct work items
     XCB_SPIN;
     cairo_push_group(cr);
+    if (bInteractiveFrame) {
+      cairo_set_antialias(cr, CAIRO_ANTIALIAS_FAST);
+      cairo_set_tolerance(cr, interactive_tolerance);
+    }
     BRUSH_SPIN;
     brush.emit(cr);
     BRUSH_CLEAR;
@@ -221,6 +241,15 @@ void uxdevice::display_context_t::render(void) {
 
     flush();
 
+    // note the area to refine, or that it has been drawn at full quality.
+    if (bInteractiveFrame) {
+      if (!refine_region)
+        refine_region.reset(cairo_region_create());
+      cairo_region_union_rectangle(refine_region.get(), &r.rect);
+    } else if (refine_region) {
+      cairo_region_subtract_rectangle(refine_region.get(), &r.rect);
+    }
+
     // processing surface requests
     apply_surface_requests();
     REGIONS_SPIN;
@@ -442,6 +471,53 @@ void uxdevice::display_context_t::state_notify_complete(void) {
   cvRenderWork.notify_one();
 }
 
+/**
+\internal
+\fn interaction
+\brief notes an interaction, such as a resize, a scroll or a frame of an
+animation. Frames drawn until interaction is idle for refine_delay are drawn
+at interactive quality when progressive is set.
+*/
+void uxdevice::display_context_t::interaction(void) {
+  last_interaction =
+      std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+/**
+\internal
+\fn interactive
+\brief true when progressive is set and there has been an interaction
+within refine_delay.
+*/
+bool uxdevice::display_context_t::interactive(void) {
+  if (!progressive)
+    return false;
+  std::chrono::steady_clock::time_point last(
+      std::chrono::steady_clock::duration(last_interaction.load()));
+  return std::chrono::steady_clock::now() - last < refine_delay;
+}
+
+/**
+\internal
+\fn refine
+\brief once interaction is idle, requests the area drawn at interactive
+quality be drawn again. Returns true when there is area to draw. Called by
+the render thread.
+*/
+bool uxdevice::display_context_t::refine(void) {
+  if (!refine_region || interactive())
+    return false;
+
+  int n = cairo_region_num_rectangles(refine_region.get());
+  for (int i = 0; i < n; i++) {
+    cairo_rectangle_int_t r;
+    cairo_region_get_rectangle(refine_region.get(), i, &r);
+    state(r.x, r.y, r.width, r.height);
+  }
+  refine_region.reset();
+  return n > 0;
+}
+
 /**
 \internal
 \brief The routine returns whether work is within the system.
@@ -76,13 +76,110 @@ typedef std::list<std::shared_ptr<drawing_output_t>>::iterator
     drawing_output_collection_iter_t;
 
 class display_context_t;
-typedef std::function<void(display_context_t &context)> draw_logic_t;
+
+/**
+\internal
+\class draw_logic_t
+\brief holds the drawing functions of a drawing_output_t. The callable is
+stored within a fixed buffer inside the object, so assigning one never
+allocates and the object is the size of a std::function. Only trivially
+copyable callables that fit within the buffer are accepted, which in practice
+is a lambda capturing this and a few pointers or numbers. Larger state
+belongs within the drawing object and is reached through this. Copy and
+assignment are plain copies of the buffer.
+*/
+class draw_logic_t {
+public:
+  static constexpr std::size_t capacity = 3 * sizeof(void *);
+
+  draw_logic_t() {}
+  draw_logic_t(std::nullptr_t) {}
+
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, draw_logic_t>::value>::type>
+  draw_logic_t(F &&f) {
+    assign(std::forward<F>(f));
+  }
+
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, draw_logic_t>::value>::type>
+  draw_logic_t &operator=(F &&f) {
+    assign(std::forward<F>(f));
+    return *this;
+  }
+
+  draw_logic_t &operator=(std::nullptr_t) {
+    invoke_function = nullptr;
+    return *this;
+  }
+
+  void operator()(display_context_t &context) const {
+    invoke_function(storage, context);
+  }
+
+  explicit operator bool() const noexcept {
+    return invoke_function != nullptr;
+  }
+
+private:
+  typedef void (*invoke_function_t)(const void *, display_context_t &);
+
+  template <typename F> void assign(F &&f) {
+    typedef typename std::decay<F>::type callable_t;
+    static_assert(sizeof(callable_t) <= capacity,
+                  "draw_logic_t callable captures too much state.");
+    static_assert(alignof(callable_t) <= alignof(void *),
+                  "draw_logic_t callable alignment is not supported.");
+    static_assert(std::is_trivially_copyable<callable_t>::value &&
+                      std::is_trivially_destructible<callable_t>::value,
+                  "draw_logic_t callable must be trivially copyable.");
+    new (storage) callable_t(std::forward<F>(f));
+    invoke_function = [](const void *p, display_context_t &context) {
+      (*static_cast<const callable_t *>(p))(context);
+    };
+  }
+
+  alignas(void *) unsigned char storage[capacity] = {};
+  invoke_function_t invoke_function = nullptr;
+};
 
 typedef struct _draw_buffer_t {
   cairo_t *cr = nullptr;
   cairo_surface_t *rendered = nullptr;
 } draw_buffer_t;
 
+/**
+\internal
+\class display_context_link_t
+\brief a reference to a display context held by functions that are called
+on background threads, such as those waiting upon decoded images, shadows
+and tiles. The context releases the link when it is destroyed, after which
+the functions do nothing. The link is locked while a function uses the
+context, so the context is not destroyed during the call.
+*/
+class display_context_link_t {
+public:
+  display_context_link_t(display_context_t *_context) : context(_context) {}
+
+  /// @brief calls fn with the context unless it has been destroyed.
+  template <typename F> void invoke(const F &fn) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (context)
+      fn(*context);
+  }
+
+  void release(void) {
+    std::lock_guard<std::mutex> guard(mutex);
+    context = nullptr;
+  }
+
+private:
+  std::mutex mutex = {};
+  display_context_t *context = nullptr;
+};
+
 class display_context_t : virtual public hash_members_t,
                           public unit_memory_storage_t {
 public:
@@ -127,6 +224,7 @@ public:
 
 public:
   display_context_t(void) {}
+  ~display_context_t() { context_link->release(); }
 
   display_context_t(const display_context_t &other) { *this = other; }
 
@@ -193,6 +291,58 @@ public:
   void state_surface(int x, int y, int w, int h);
   void state_notify_complete(void);
 
+  void interaction(void);
+  bool interactive(void);
+
+  /// @brief the link used by functions called on other threads to reach the
+  /// context while it exists.
+  std::shared_ptr<display_context_link_t> link(void) const noexcept {
+    return context_link;
+  }
+
+  /// @brief true while the frame being drawn is drawn at interactive quality.
+  bool interactive_frame(void) const noexcept { return bInteractiveFrame; }
+
+  /// @brief the filter of scaled images drawn within the current frame.
+  cairo_filter_t filter(void) const noexcept {
+    return bInteractiveFrame ? CAIRO_FILTER_FAST : CAIRO_FILTER_GOOD;
+  }
+
+  /// @brief the attribute memory read and changed by units. While the render
+  /// thread merges a command buffer, it is the memory of the buffer, so the
+  /// attributes streamed by the application thread are not touched.
+  unit_memory_storage_t &attributes(void) noexcept {
+    if (replay.context == this)
+      return *replay.memory;
+    return *this;
+  }
+  const unit_memory_storage_t &attributes(void) const noexcept {
+    if (replay.context == this)
+      return *replay.memory;
+    return *this;
+  }
+
+  /// @brief selects the attribute memory used by the calling thread, nullptr
+  /// restores the memory of the context.
+  void attributes(unit_memory_storage_t *memory) noexcept {
+    replay = {memory ? this : nullptr, memory};
+  }
+
+  template <typename T> void unit_memory(const std::shared_ptr<T> ptr) {
+    attributes().unit_memory<T>(ptr);
+  }
+  template <typename T>
+  void unit_memory(const std::shared_ptr<display_unit_t> ptr) {
+    attributes().unit_memory<T>(ptr);
+  }
+  template <typename T>
+  auto unit_memory(void) const noexcept -> const std::shared_ptr<T> {
+    return attributes().unit_memory<T>();
+  }
+  template <typename T> void unit_memory_erase(void) {
+    attributes().unit_memory_erase<T>();
+  }
+
   draw_buffer_t allocate_buffer(int width, int height);
   static void destroy_buffer(draw_buffer_t &_buffer);
   void clear(void);
@@ -311,6 +461,28 @@ private:
 
   int offsetx = 0, offsety = 0;
   void apply_surface_requests(void);
+  bool refine(void);
+
+  // the time of the last interaction, as a count of the steady clock.
+  std::atomic<std::chrono::steady_clock::rep> last_interaction = {};
+
+  // the area drawn at interactive quality since it was last refined, and
+  // whether the frame being drawn is interactive. Used by the render thread.
+  std::unique_ptr<cairo_region_t, void (*)(cairo_region_t *)> refine_region = {
+      nullptr, cairo_region_destroy};
+  bool bInteractiveFrame = false;
+
+  // the attribute memory selected by the calling thread for a context.
+  typedef struct _replay_attributes_t {
+    const display_context_t *context;
+    unit_memory_storage_t *memory;
+  } replay_attributes_t;
+  static inline thread_local replay_attributes_t replay = {nullptr, nullptr};
+
+  // not copied, each context has its own link.
+  std::shared_ptr<display_context_link_t> context_link =
+      std::make_shared<display_context_link_t>(this);
+
   std::mutex mutexRenderWork = {};
   std::condition_variable cvRenderWork = {};
 
@@ -318,6 +490,14 @@ public:
   // if render request time for objects are less than x ms
   int cache_threshold = 200;
 
+  // when set, frames drawn within refine_delay of an interaction use fast
+  // antialiasing, image filters and a coarser tolerance. The area drawn so
+  // is drawn again at full quality once interaction is idle.
+  std::atomic<bool> progressive = false;
+  static constexpr std::chrono::milliseconds refine_delay =
+      std::chrono::milliseconds(150);
+  static constexpr double interactive_tolerance = 0.5;
+
   std::atomic<bool> clearing_frame = false;
   Display *xdisplay = nullptr;
   xcb_connection_t *connection = nullptr;
@@ -179,6 +179,22 @@ public:
 
 } // namespace uxdevice
 
+/**
+\internal
+\brief marks units that paint the current path, such as stroke and fill.
+When the surface is recording, these units complete a recorded path. The
+path_extents function reports the area painted within user coordinates. When
+false is returned, the operation is not bounded by the path.
+*/
+namespace uxdevice {
+class path_paint_abstract_t {
+public:
+  virtual ~path_paint_abstract_t() {}
+  virtual bool path_extents(cairo_t *cr, cairo_rectangle_t &r) = 0;
+};
+
+} // namespace uxdevice
+
 /**
 \internal
 \class display_unit_t
@@ -337,6 +353,10 @@ public:
 
   bool is_output(void) { return true; }
 
+  /// @brief notes the areas that changed since the last render as context
+  /// states. Returns false when the ink rectangle should be painted whole.
+  virtual bool state_damage(display_context_t &context) { return false; }
+
   // These functions switch the rendering apparatus from off
   // screen threaded to on screen. all rendering is serialize to the main
   // surface
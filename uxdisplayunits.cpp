@@ -52,6 +52,7 @@ void uxdevice::text_render_normal_t::emit(display_context_t &context) {
   // the emit function removes the text_render_path_t from the display memory
   // as they are exclusive
   context.unit_memory_erase<text_render_path_t>();
+  context.unit_memory_erase<text_render_atlas_t>();
 }
 
 /**
@@ -69,6 +70,26 @@ Text can bend to follow a path if logic is added.
  */
 void uxdevice::text_render_path_t::emit(display_context_t &context) {
   context.unit_memory_erase<text_render_normal_t>();
+  context.unit_memory_erase<text_render_atlas_t>();
+}
+
+/**
+
+\fn text_render_atlas_t::emit
+
+\param display_context_t &context
+
+\brief outputs text by masking the text_color_t brush with glyph coverage
+taken from the shared glyph atlas. Each glyph is rasterized once per font,
+size and subpixel position. Repeated text reuses the mask of its shared
+layout.
+
+\details
+
+ */
+void uxdevice::text_render_atlas_t::emit(display_context_t &context) {
+  context.unit_memory_erase<text_render_normal_t>();
+  context.unit_memory_erase<text_render_path_t>();
 }
 
 /**
@@ -134,12 +155,20 @@ void uxdevice::coordinate_t::emit_relative(cairo_t *cr) {
 void uxdevice::coordinate_t::emit_absolute(cairo_t *cr) {
   cairo_move_to(cr, x, y);
 }
+/**
+\internal
+\fn coordinate_t::emit(PangoLayout *layout)
+\brief sets the size of the layout. A negative width or height is passed as
+-1, the pango default of no wrapping and no height limit.
+*/
 void uxdevice::coordinate_t::emit(PangoLayout *layout) {
-  if (pango_layout_get_width(layout) != w * PANGO_SCALE)
-    pango_layout_set_width(layout, w * PANGO_SCALE);
+  int width = w < 0 ? -1 : static_cast<int>(w * PANGO_SCALE);
+  if (pango_layout_get_width(layout) != width)
+    pango_layout_set_width(layout, width);
 
-  if (pango_layout_get_height(layout) != h * PANGO_SCALE)
-    pango_layout_set_height(layout, h * PANGO_SCALE);
+  int height = h < 0 ? -1 : static_cast<int>(h * PANGO_SCALE);
+  if (pango_layout_get_height(layout) != height)
+    pango_layout_set_height(layout, height);
 }
 
 /**
@@ -215,7 +244,7 @@ void uxdevice::text_tab_stops_t::emit(PangoLayout *layout) {
  */
 void uxdevice::text_font_t::emit(PangoLayout *layout) {
   if (!font_ptr) {
-    font_ptr = pango_font_description_from_string(description.data());
+    font_ptr = font_registry_t::description(description);
     if (!font_ptr) {
       std::string s = "Font could not be loaded from description. ( ";
       s += description + ")";
@@ -298,6 +327,40 @@ void uxdevice::text_data_t::emit(PangoLayout *layout) {
   std::visit(text_data_visitor, value);
 }
 
+/**
+\internal
+\fn text_data_t::is_editable
+\brief true when the text is held by a shared pointer to a string or string
+stream. The text may be changed after it was inserted.
+*/
+bool uxdevice::text_data_t::is_editable(void) const noexcept {
+  return std::holds_alternative<std::shared_ptr<std::string>>(value) ||
+         std::holds_alternative<std::shared_ptr<std::stringstream>>(value);
+}
+
+/**
+\internal
+\fn text_data_t::view
+\param std::string &buffer - receives a copy when the text is held by a
+string stream.
+\brief returns a view of the text.
+*/
+std::string_view uxdevice::text_data_t::view(std::string &buffer) const {
+  auto text_data_visitor = overload_visitors_t{
+      [&](const std::string &s) { return std::string_view(s); },
+      [&](const std::string_view &s) { return s; },
+      [&](const std::shared_ptr<std::string> &ps) {
+        return std::string_view(*ps);
+      },
+      [&](const std::shared_ptr<std::string_view> &ps) { return *ps; },
+      [&](const std::shared_ptr<std::stringstream> &ps) {
+        buffer = ps->str();
+        return std::string_view(buffer);
+      }};
+
+  return std::visit(text_data_visitor, value);
+}
+
 /**
 
 \fn textual_render_storage_t::hash_code(void)
@@ -310,322 +373,526 @@ that might occur within all of the dependent rendering parameters,
 
  */
 std::size_t uxdevice::textual_render_storage_t::hash_code(void) const noexcept {
+  // text that is not editable does not change once inserted, so it is
+  // represented by its object rather than hashed on every frame.
+  auto text_data = unit_memory<text_data_t>();
+  std::size_t text_hash =
+      text_data->is_editable()
+          ? text_data->hash_code()
+          : std::hash<std::shared_ptr<text_data_t>>{}(text_data);
+
   std::size_t __value = {};
   hash_combine(
       __value, std::type_index(typeid(textual_render_storage_t)),
-      pango_layout_get_serial(layout), ink_rect.x, ink_rect.y, ink_rect.width,
+      layout_key.hash_code(), ink_rect.x, ink_rect.y, ink_rect.width,
       ink_rect.height, matrix.hash_code(), unit_memory<text_color_t>(),
       unit_memory<text_outline_t>(), unit_memory<text_fill_t>(),
       unit_memory<text_shadow_t>(), unit_memory<text_alignment_t>(),
       unit_memory<text_indent_t>(), unit_memory<text_ellipsize_t>(),
       unit_memory<text_line_space_t>(), unit_memory<text_tab_stops_t>(),
-      unit_memory<text_font_t>(), unit_memory<text_data_t>()->hash_code(),
-      unit_memory<coordinate_t>(), unit_memory<antialias_t>(),
-      unit_memory<line_width_t>(), unit_memory<line_cap_t>(),
-      unit_memory<line_join_t>(), unit_memory<miter_limit_t>(),
-      unit_memory<line_dashes_t>(), unit_memory<tollerance_t>(),
-      unit_memory<graphic_operator_t>());
+      unit_memory<text_font_t>(), text_hash, unit_memory<coordinate_t>(),
+      unit_memory<antialias_t>(), unit_memory<line_width_t>(),
+      unit_memory<line_cap_t>(), unit_memory<line_join_t>(),
+      unit_memory<miter_limit_t>(), unit_memory<line_dashes_t>(),
+      unit_memory<tollerance_t>(), unit_memory<graphic_operator_t>());
   return __value;
 }
 
 /**
 \internal
-\fn set_layout_options
-\brief manages the layout options.
-
-\details
+\fn text_layout_key
+\brief the shaping parameters of the text from the unit memory. Objects with
+equal keys share one layout.
+*/
+uxdevice::text_layout_key_t uxdevice::textual_render_storage_t::text_layout_key(
+    const unit_memory_storage_t &memory) {
+  text_layout_key_t key = {};
+  auto coordinate = memory.unit_memory<coordinate_t>();
+
+  auto text_data = memory.unit_memory<text_data_t>();
+  key.text_hash = text_data->hash_code();
+  std::string buffer = {};
+  key.text = text_data->view(buffer);
+  key.font_description = memory.unit_memory<text_font_t>()->description;
+  key.width =
+      coordinate->w < 0 ? -1 : static_cast<int>(coordinate->w * PANGO_SCALE);
+  key.height =
+      coordinate->h < 0 ? -1 : static_cast<int>(coordinate->h * PANGO_SCALE);
+
+  if (auto alignment = memory.unit_memory<text_alignment_t>())
+    key.alignment = static_cast<int>(alignment->value);
+
+  if (auto indent = memory.unit_memory<text_indent_t>())
+    key.indent = indent->value;
+
+  if (auto line_space = memory.unit_memory<text_line_space_t>())
+    key.line_space = line_space->value;
+
+  if (auto ellipsize = memory.unit_memory<text_ellipsize_t>())
+    key.ellipsize = static_cast<int>(ellipsize->value);
+
+  if (auto tab_stops = memory.unit_memory<text_tab_stops_t>())
+    for (auto n : tab_stops->value)
+      hash_combine(key.tab_stops_hash, n);
+
+  return key;
+}
 
+/**
+\internal
+\fn layout_attributes_hash
+\brief the hash of the attributes within the unit memory that the layout key
+is made from, other than the text. The key is only made again when this hash
+or the text object changes.
+*/
+std::size_t uxdevice::textual_render_storage_t::layout_attributes_hash(void) {
+  auto coordinate = unit_memory<coordinate_t>();
+  std::size_t __value = {};
+  hash_combine(__value, coordinate->w, coordinate->h,
+               unit_memory_hash_code<text_font_t>(),
+               unit_memory_hash_code<text_alignment_t>(),
+               unit_memory_hash_code<text_indent_t>(),
+               unit_memory_hash_code<text_line_space_t>(),
+               unit_memory_hash_code<text_ellipsize_t>(),
+               unit_memory_hash_code<text_tab_stops_t>());
+  return __value;
+}
 
+/**
+\internal
+\fn set_layout_options
+\brief manages the layout options. The shaped layout is obtained from the
+text layout cache so objects having the same text and layout parameters are
+shaped once. Returns true when the layout has changed.
+
+\details The cairo context is not used. Cached layouts use a shared pango
+context and are not updated to a particular cairo context. Text that may be
+edited after insertion is laid out by paragraph, so an edit shapes only the
+paragraphs that changed.
+
+The key holds a copy of the text. It is made only when the text object or
+the hash of the layout attributes has changed, so drawing a text that is
+not editable does not copy, hash or compare the text. Editable text is
+compared with the text the paragraphs were laid out from.
  */
 bool uxdevice::textual_render_storage_t::set_layout_options(cairo_t *cr) {
-  bool ret = false;
+  auto text_data = unit_memory<text_data_t>();
+  std::size_t attributes = layout_attributes_hash();
+  bool current = text_data == layout_data && attributes == layout_attributes;
+  text_layout_key_t key = {};
+
+  if (text_data->is_editable()) {
+    std::string buffer = {};
+    std::string_view text = text_data->view(buffer);
+    if (current && !paragraphs.empty() && paragraphs.is_current(text))
+      return false;
+
+    key = text_layout_key(*this);
+    paragraphs.update(text, key,
+                      [&](PangoLayout *l) { layout_options(*this, l); });
+    layout = nullptr;
+    ink_rect = paragraphs.ink_rect;
+    logical_rect = paragraphs.logical_rect;
 
-  // create layout
-  if (!layout)
-    layout = pango_cairo_create_layout(cr);
+  } else {
+    if (current && shaped_layout)
+      return false;
+
+    key = text_layout_key(*this);
+    layout_data = text_data;
+    layout_attributes = attributes;
+    if (shaped_layout && key == layout_key)
+      return false;
+
+    // a layout requested when the text was inserted is waited for.
+    if (pending_layout.valid() && key == pending_key) {
+      shaped_layout = pending_layout.get();
+    } else {
+      // the setup is only called when the layout is not cached.
+      shaped_layout = text_layout_cache_t::acquire(
+          key, [&](PangoLayout *l) { layout_text(*this, l); });
+    }
+    pending_layout = {};
+    layout = shaped_layout->layout;
+    ink_rect = shaped_layout->ink_rect;
+    logical_rect = shaped_layout->logical_rect;
+  }
 
-  // get the serial number of all the current attributes.
-  // if any of the emitter functions change the layout
-  // the serial number changes.
-  guint layoutSerial = pango_layout_get_serial(layout);
+  layout_key = std::move(key);
+  layout_data = text_data;
+  layout_attributes = attributes;
+  shadow_layout_current = false;
 
-  // emit the text rendering attributes from unit storage.
-  unit_memory<text_font_t>()->emit(layout);
+  auto coordinate = unit_memory<coordinate_t>();
+  int tw = std::min((double)logical_rect.width, coordinate->w);
+  int th = std::min((double)logical_rect.height, coordinate->h);
+  ink_rectangle = {(int)coordinate->x, (int)coordinate->y, tw, th};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
 
-  if (unit_memory<text_alignment_t>()) {
-    unit_memory<text_alignment_t>()->emit(layout);
-  }
+  has_ink_extents = true;
 
-  // set the width and height of the layout.
-  unit_memory<coordinate_t>()->emit(layout);
+  return true;
+}
 
-  // set the text data
-  unit_memory<text_data_t>()->emit(layout);
-
-  // any changes
-  if (layoutSerial != pango_layout_get_serial(layout)) {
-    auto coordinate = unit_memory<coordinate_t>();
-    pango_layout_get_pixel_extents(layout, &ink_rect, &logical_rect);
-    int tw = std::min((double)logical_rect.width, coordinate->w);
-    int th = std::min((double)logical_rect.height, coordinate->h);
-    ink_rectangle = {(int)coordinate->x, (int)coordinate->y, tw, th};
-    ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
-                            (double)ink_rectangle.width,
-                            (double)ink_rectangle.height};
-
-    has_ink_extents = true;
-    ret = true;
-  }
+/**
+\internal
+\fn request_layout
+\brief requests the layout of the text from the shaping threads so texts
+inserted in quick succession are shaped in parallel. The layout is taken
+when the text is first drawn. Until then the ink rectangle is the whole
+coordinate, which holds the text once shaped.
+
+\details The setup works from a copy of the unit memory since it runs after
+this function returns. Text that may be edited is laid out by paragraph when
+drawn as its contents may change before then.
+*/
+void uxdevice::textual_render_storage_t::request_layout(void) {
+  auto coordinate = unit_memory<coordinate_t>();
+  ink_rectangle = {(int)coordinate->x, (int)coordinate->y,
+                   (int)coordinate->w, (int)coordinate->h};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = true;
+
+  if (unit_memory<text_data_t>()->is_editable())
+    return;
+
+  unit_memory_storage_t memory = {};
+  memory.copy_unit_memory(*this);
 
-  return ret;
+  pending_key = text_layout_key(*this);
+  pending_layout = text_layout_cache_t::acquire_async(
+      pending_key, [memory](PangoLayout *l) { layout_text(memory, l); });
 }
 
 /**
 \internal
-\fn create_shadow
-\brief creates an image of the shadowed text
+\fn layout_options
+\brief applies the font and paragraph options within the unit memory to a
+new layout.
+*/
+void uxdevice::textual_render_storage_t::layout_options(
+    const unit_memory_storage_t &memory, PangoLayout *l) {
+  memory.unit_memory<text_font_t>()->emit(l);
 
-\details
+  if (memory.unit_memory<text_alignment_t>())
+    memory.unit_memory<text_alignment_t>()->emit(l);
 
+  if (memory.unit_memory<text_indent_t>())
+    memory.unit_memory<text_indent_t>()->emit(l);
 
- */
-void uxdevice::textual_render_storage_t::create_shadow(void) {
-  // if the text has changed, recreate the shadow texture
-  if (unit_memory<text_data_t>()->has_changed()) {
-    if (shadow_image) {
-      cairo_surface_destroy(shadow_image);
-      shadow_image = nullptr;
-    }
+  if (memory.unit_memory<text_line_space_t>())
+    memory.unit_memory<text_line_space_t>()->emit(l);
 
-    if (shadow_cr) {
-      cairo_destroy(shadow_cr);
-      shadow_cr = nullptr;
-    }
-  }
+  if (memory.unit_memory<text_ellipsize_t>())
+    memory.unit_memory<text_ellipsize_t>()->emit(l);
 
-  if (!shadow_image) {
-    auto text_shadow = unit_memory<text_shadow_t>();
-    shadow_image = cairo_image_surface_create(
-        CAIRO_FORMAT_ARGB32, ink_rectangle.width + text_shadow->x,
-        ink_rectangle_double.height + text_shadow->y);
-    shadow_cr = cairo_create(shadow_image);
-    // offset text by the parameter amounts
-    cairo_move_to(shadow_cr, text_shadow->x, text_shadow->y);
-    if (set_layout_options(shadow_cr))
-      pango_cairo_update_layout(shadow_cr, layout);
-    text_shadow->emit(shadow_cr);
-    pango_cairo_show_layout(shadow_cr, layout);
-
-#if defined(USE_STACKBLUR)
-    blur_image(shadow_image, text_shadow->radius);
-
-#elif defined(USE_SVGREN)
-    cairo_surface_t *blurred = blur_image(shadow_image, text_shadow->radius);
-    cairo_surface_destroy(shadow_image);
-    shadow_image = blurred;
-#endif
-  }
+  if (memory.unit_memory<text_tab_stops_t>())
+    memory.unit_memory<text_tab_stops_t>()->emit(l);
 }
 
 /**
 \internal
-\fn invoke
-\brief creates linkage to the drawing function based upon the rendering
-parameters set.
-
-\details
+\fn layout_text
+\brief applies the options, the size of the coordinate and the text within
+the unit memory to a new layout. This is the setup of every layout in the
+text layout cache that is keyed by text_layout_key().
+*/
+void uxdevice::textual_render_storage_t::layout_text(
+    const unit_memory_storage_t &memory, PangoLayout *l) {
+  layout_options(memory, l);
 
+  // set the width and height of the layout.
+  memory.unit_memory<coordinate_t>()->emit(l);
 
- */
-uxdevice::textual_render_storage_t::internal_cairo_function_t
-uxdevice::textual_render_storage_t::precise_rendering_function(void) {
-  enum text_rendering_lambda_t {
-    text_rendering_default,
-    text_rendering_normal_lambda,
-    text_rendering_normal_shadowed_lambda,
-    text_rendering_fill_lambda,
-    text_rendering_outline_lambda,
-    text_rendering_fill_outline_lambda,
-    text_rendering_fill_shadowed_lambda,
-    text_rendering_outline_shadowed_lambda,
-    text_rendering_fill_outline_shadowed_lambda
-  };
-  text_rendering_lambda_t text_render_type = {};
-  internal_cairo_function_t fn;
+  // set the text data
+  memory.unit_memory<text_data_t>()->emit(l);
+}
 
-  if (unit_memory<text_render_path_t>()) {
-    if (unit_memory<text_fill_t>() && unit_memory<text_outline_t>() &&
-        unit_memory<text_shadow_t>())
-      text_render_type = text_rendering_fill_outline_shadowed_lambda;
+/**
+\internal
+\fn frame_layout
+\brief the layout drawn within the current frame. Interactive frames use a
+layout shaped with gray font antialiasing. It is shaped by the text layout
+cache on first use, and the layout is drawn until it is ready.
+*/
+uxdevice::text_layout_t *
+uxdevice::textual_render_storage_t::frame_layout(void) {
+  if (!context || !context->interactive_frame())
+    return shaped_layout.get();
+
+  if (interactive_source != shaped_layout.get()) {
+    unit_memory_storage_t memory = {};
+    memory.copy_unit_memory(*this);
+
+    text_layout_key_t key = layout_key;
+    key.interactive = true;
+    interactive_layout = text_layout_cache_t::acquire_async(
+        key, [memory](PangoLayout *l) { layout_text(memory, l); });
+    interactive_source = shaped_layout.get();
+  }
 
-    else if (unit_memory<text_fill_t>() && unit_memory<text_outline_t>())
-      text_render_type = text_rendering_fill_outline_lambda;
+  if (interactive_layout.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready)
+    return shaped_layout.get();
 
-    else if (unit_memory<text_fill_t>() && unit_memory<text_shadow_t>())
-      text_render_type = text_rendering_fill_shadowed_lambda;
+  return interactive_layout.get().get();
+}
 
-    else if (unit_memory<text_outline_t>() && unit_memory<text_shadow_t>())
-      text_render_type = text_rendering_outline_shadowed_lambda;
+/**
+\internal
+\fn show_layout
+\brief draws the text with the top left corner at x, y. Paragraph layouts
+only draw the paragraphs within the clip.
+*/
+void uxdevice::textual_render_storage_t::show_layout(cairo_t *cr, double x,
+                                                     double y) {
+  if (layout) {
+    cairo_move_to(cr, x, y);
+    frame_layout()->show(cr);
+  } else {
+    paragraphs.show(cr, x, y);
+  }
+}
 
-    else if (unit_memory<text_fill_t>())
-      text_render_type = text_rendering_fill_lambda;
+/**
+\internal
+\fn layout_path
+\brief adds the outline of the text at x, y to the current path.
+*/
+void uxdevice::textual_render_storage_t::layout_path(cairo_t *cr, double x,
+                                                     double y) {
+  if (layout) {
+    cairo_move_to(cr, x, y);
+    shaped_layout->path(cr);
+  } else {
+    paragraphs.path(cr, x, y);
+  }
+}
 
-    else if (unit_memory<text_outline_t>())
-      text_render_type = text_rendering_outline_lambda;
+/**
+\internal
+\fn mask_layout
+\brief paints the source through the glyph atlas coverage of the text.
+*/
+void uxdevice::textual_render_storage_t::mask_layout(cairo_t *cr, double x,
+                                                     double y) {
+  if (layout) {
+    cairo_mask_surface(cr, shaped_layout->glyph_mask(),
+                       x + shaped_layout->mask_x, y + shaped_layout->mask_y);
   } else {
-    if (unit_memory<text_color_t>() && unit_memory<text_shadow_t>())
-      text_render_type = text_rendering_normal_shadowed_lambda;
+    paragraphs.mask(cr, x, y);
+  }
+}
 
-    else if (unit_memory<text_color_t>())
-      text_render_type = text_rendering_normal_lambda;
+/**
+\internal
+\fn state_damage
+\brief lays out edited text again and notes the areas of the paragraphs that
+changed or moved, clipped to the coordinate. Returns false for text that is
+not laid out by paragraph or when the layout is unchanged, so the whole ink
+rectangle is painted.
+*/
+bool uxdevice::textual_render_storage_t::state_damage(
+    display_context_t &context) {
+  auto text_data = unit_memory<text_data_t>();
+  if (!text_data || !text_data->is_editable())
+    return false;
+
+  if (!set_layout_options(nullptr))
+    return false;
+
+  auto coordinate = unit_memory<coordinate_t>();
+  int w = static_cast<int>(coordinate->w);
+  int h = static_cast<int>(coordinate->h);
+  for (auto &r : paragraphs.damaged) {
+    int x1 = std::max(r.x, 0);
+    int y1 = std::max(r.y, 0);
+    int x2 = std::min(r.x + r.width, w);
+    int y2 = std::min(r.y + r.height, h);
+    if (x2 > x1 && y2 > y1)
+      context.state(static_cast<int>(coordinate->x) + x1,
+                    static_cast<int>(coordinate->y) + y1, x2 - x1, y2 - y1);
   }
+  paragraphs.damaged.clear();
 
-#define FN_SHADOW                                                              \
-  create_shadow();                                                             \
-  cairo_set_source_surface(cr, shadow_image, a.x, a.y);                        \
-  cairo_rectangle(cr, a.x, a.y, a.w, a.h);                                     \
-  cairo_fill(cr);
+  return true;
+}
 
-  // set the drawing function to the one that will be used by the rendering
-  // options for text. These functions accept five parameters.
-  // These are the clipping versions that have coordinate_t.
+/**
+\internal
+\fn create_shadow
+\brief obtains the blurred shadow of the text from the text shadow cache.
+Returns true when the shadow is ready to be painted.
 
-  switch (text_render_type) {
-  case text_rendering_default:
-  case text_rendering_normal_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
+\details Texts with the same layout and shadow parameters share one shadow.
+A new shadow is blurred in the background. The text is drawn without it
+until it is ready, at which time the area is painted again.
 
-      a.emit(cr);
-      unit_memory<text_color_t>()->emit(cr, a);
-      pango_cairo_show_layout(cr, layout);
+ */
+bool uxdevice::textual_render_storage_t::create_shadow(void) {
+  auto text_shadow = unit_memory<text_shadow_t>();
+
+  text_shadow_key_t key = {};
+  key.x = text_shadow->x;
+  key.y = text_shadow->y;
+  key.radius = text_shadow->radius;
+  key.width = ink_rectangle.width + static_cast<int>(text_shadow->x);
+  key.height = ink_rectangle.height + static_cast<int>(text_shadow->y);
+
+  // the layout part of the key, which holds the text, is only compared when
+  // the layout has changed since the shadow was obtained.
+  if (shadow && shadow_layout_current && key.x == shadow_key.x &&
+      key.y == shadow_key.y && key.radius == shadow_key.radius &&
+      key.width == shadow_key.width && key.height == shadow_key.height)
+    return shadow->is_ready() && shadow->surface;
+
+  key.layout = layout_key;
+  shadow_layout_current = true;
+
+  if (!shadow || !(key == shadow_key)) {
+    // the mask is blurred by the text shadow cache.
+    auto fn_rasterize = [&]() {
+      return shadow_mask(key.width, key.height, [&](cairo_t *cr) {
+        // offset text by the parameter amounts
+        show_layout(cr, text_shadow->x, text_shadow->y);
+      });
     };
-  } break;
 
-  case text_rendering_normal_shadowed_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-
-      // drawing_output_t::invoke(cr);
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
+    text_shadow_cache_t::ready_t fn_ready = {};
+    if (context) {
+      auto link = context->link();
+      cairo_rectangle_int_t r = {ink_rectangle.x, ink_rectangle.y, key.width,
+                                 key.height};
+      fn_ready = [link, r]() {
+        link->invoke([&](display_context_t &context) {
+          context.state(r.x, r.y, r.width, r.height);
+          context.state_notify_complete();
+        });
+      };
+    }
 
-      FN_SHADOW
+    shadow = text_shadow_cache_t::acquire(key, fn_rasterize, fn_ready);
+    shadow_key = key;
+  }
 
-      a.emit(cr);
-      unit_memory<text_color_t>()->emit(cr, a);
-      pango_cairo_show_layout(cr, layout);
-    };
+  return shadow->is_ready() && shadow->surface;
+}
 
-  } break;
+/**
+\internal
+\fn render_text
+\brief draws the text. The routine is instantiated for each combination of
+paint, shadow and drawing options so the tests are resolved at compile time
+and a routine contains only the work of its combination. Plain colored text
+is laid out, the brush set and the layout shown.
+*/
+template <uxdevice::textual_render_storage_t::text_paint_t paint,
+          bool bShadow, bool bOptions>
+void uxdevice::textual_render_storage_t::render_text(
+    textual_render_storage_t &text, cairo_t *cr, coordinate_t &a) {
+  if constexpr (bOptions)
+    for (auto &fn : text.options.value)
+      fn(cr);
+
+  text.set_layout_options(cr);
+
+  if constexpr (bShadow) {
+    if (text.create_shadow()) {
+      cairo_save(cr);
+      cairo_rectangle(cr, a.x, a.y, a.w, a.h);
+      cairo_clip(cr);
+      text.render_shadow->emit(cr, a);
+      cairo_mask_surface(cr, text.shadow->surface, a.x, a.y);
+      cairo_restore(cr);
+    }
+  }
 
-  case text_rendering_fill_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
+  if constexpr (paint == text_paint_t::color) {
+    text.render_color->emit(cr, a);
+    text.show_layout(cr, a.x, a.y);
 
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
-      a.emit(cr);
+  } else if constexpr (paint == text_paint_t::atlas) {
+    text.render_color->emit(cr, a);
+    text.mask_layout(cr, a.x, a.y);
 
-      pango_cairo_layout_path(cr, layout);
-      unit_memory<text_fill_t>()->emit(cr, a);
+  } else {
+    text.layout_path(cr, a.x, a.y);
+    if constexpr (paint == text_paint_t::fill) {
+      text.render_fill->emit(cr, a);
       cairo_fill(cr);
-    };
-
-  } break;
-
-  case text_rendering_outline_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
-
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
-
-      a.emit(cr);
-      pango_cairo_layout_path(cr, layout);
-      unit_memory<text_outline_t>()->emit(cr, a);
+    } else if constexpr (paint == text_paint_t::outline) {
+      text.render_outline->emit(cr, a);
       cairo_stroke(cr);
-    };
-  } break;
-
-  case text_rendering_fill_outline_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
-
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
-
-      a.emit(cr);
-      pango_cairo_layout_path(cr, layout);
-      unit_memory<text_fill_t>()->emit(cr, a);
+    } else {
+      text.render_fill->emit(cr, a);
       cairo_fill_preserve(cr);
-      unit_memory<text_outline_t>()->emit(cr, a);
+      text.render_outline->emit(cr, a);
       cairo_stroke(cr);
-    };
-  } break;
-
-  case text_rendering_fill_shadowed_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
-
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
-
-      FN_SHADOW
-
-      a.emit(cr);
-      pango_cairo_layout_path(cr, layout);
-      unit_memory<text_fill_t>()->emit(cr, a);
-      cairo_fill(cr);
-    };
-  } break;
-
-  case text_rendering_outline_shadowed_lambda: {
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
-
-      FN_SHADOW
-
-      a.emit(cr);
-      pango_cairo_layout_path(cr, layout);
-      unit_memory<text_outline_t>()->emit(cr, a);
-      cairo_stroke(cr);
-    };
-  } break;
+    }
+  }
+}
 
-  case text_rendering_fill_outline_shadowed_lambda: {
+/**
+\internal
+\fn precise_rendering_function
+\brief selects the drawing routine for the rendering attributes within the
+unit memory and notes the brushes it uses.
 
-    fn = [=](cairo_t *cr, coordinate_t a) {
-      // cairo_set_matrix(context.cr, &mat._matrix);
-      // drawing_output_t::invoke(cr);
+\details fill and outline are painted when text_render_path_t is set, or
+when there is no text_color_t. The atlas is used when text_render_atlas_t is
+set and there is a text_color_t.
 
-      if (set_layout_options(cr))
-        pango_cairo_update_layout(cr, layout);
+ */
+uxdevice::textual_render_storage_t::text_render_function_t
+uxdevice::textual_render_storage_t::precise_rendering_function(void) {
+  render_color = unit_memory<text_color_t>().get();
+  render_fill = unit_memory<text_fill_t>().get();
+  render_outline = unit_memory<text_outline_t>().get();
+  render_shadow = unit_memory<text_shadow_t>().get();
+
+  text_paint_t paint = text_paint_t::color;
+  if (unit_memory<text_render_path_t>() || !render_color) {
+    if (render_fill && render_outline)
+      paint = text_paint_t::fill_outline;
+    else if (render_fill)
+      paint = text_paint_t::fill;
+    else if (render_outline)
+      paint = text_paint_t::outline;
+  } else if (unit_memory<text_render_atlas_t>()) {
+    paint = text_paint_t::atlas;
+  }
 
-      FN_SHADOW
+  bool bShadow = render_shadow != nullptr;
+  bool bOptions = !options.value.empty();
 
-      a.emit(cr);
-      pango_cairo_layout_path(cr, layout);
-      unit_memory<text_fill_t>()->emit(cr, a);
-      cairo_fill_preserve(cr);
-      unit_memory<text_outline_t>()->emit(cr, a);
-      cairo_stroke(cr);
-    };
+  auto fn_select = [bShadow, bOptions](auto p) -> text_render_function_t {
+    constexpr text_paint_t paint = decltype(p)::value;
+    if (bShadow)
+      return bOptions ? render_text<paint, true, true>
+                      : render_text<paint, true, false>;
+    return bOptions ? render_text<paint, false, true>
+                    : render_text<paint, false, false>;
+  };
 
-  } break;
+  using paint_t = text_paint_t;
+  switch (paint) {
+  case paint_t::color:
+    return fn_select(std::integral_constant<paint_t, paint_t::color>{});
+  case paint_t::atlas:
+    return fn_select(std::integral_constant<paint_t, paint_t::atlas>{});
+  case paint_t::fill:
+    return fn_select(std::integral_constant<paint_t, paint_t::fill>{});
+  case paint_t::outline:
+    return fn_select(std::integral_constant<paint_t, paint_t::outline>{});
+  case paint_t::fill_outline:
+    return fn_select(
+        std::integral_constant<paint_t, paint_t::fill_outline>{});
   }
-
-  return fn;
+  return nullptr;
 }
 
 /**
@@ -638,11 +905,10 @@ uxdevice::textual_render_storage_t::precise_rendering_function(void) {
 
  */
 void uxdevice::textual_render_t::emit(display_context_t &context) {
-  using namespace std::placeholders;
-
   // create a linkage snapshot to the shared pointers stored in unit memory
   // within the stream context.
-  copy_unit_memory(context);
+  copy_unit_memory(context.attributes());
+  this->context = &context;
 
   // check the context parameters before operating
   if (!((unit_memory<text_color_t>() || unit_memory<text_outline_t>() ||
@@ -654,25 +920,28 @@ void uxdevice::textual_render_t::emit(display_context_t &context) {
         "attributes: A text_color_t, text_outline_t or "
         " text_fill_t. As well, a coordinate_t, text and text_font_t object.";
     UX_ERROR_DESC(s);
-    auto fn = [=](display_context_t &context) {};
+    auto fn = [](display_context_t &context) {};
 
-    fn_base_surface = std::bind(fn, _1);
-    fn_cache_surface = std::bind(fn, _1);
-    fn_draw = std::bind(fn, _1);
-    fn_draw_clipped = std::bind(fn, _1);
+    fn_base_surface = fn;
+    fn_cache_surface = fn;
+    fn_draw = fn;
+    fn_draw_clipped = fn;
     return;
   }
 
   // cairo_get_matrix(context.cr, &mat._matrix);
 
-  auto fn = precise_rendering_function();
-  auto &coordinate = *unit_memory<coordinate_t>();
+  // the rendering function is held by the object so the drawing functions
+  // only capture this and the coordinate, which is kept alive by the unit
+  // memory snapshot.
+  fn_render = precise_rendering_function();
+  coordinate_t *pcoordinate = unit_memory<coordinate_t>().get();
 
   // two functions provide mode switching for the rendering.
   // a cache surface is a new xcb surface that can be threaded in creation
   // base surface issues the drawing commands to the base window drawing cairo
   // context. base surface creation is not threaded.
-  fn_cache_surface = [=](display_context_t &context) {
+  fn_cache_surface = [this, pcoordinate](display_context_t &context) {
     // if the item is already cached, return.
     if (bRenderBufferCached)
       return;
@@ -688,7 +957,7 @@ void uxdevice::textual_render_t::emit(display_context_t &context) {
     set_layout_options(internal_buffer.cr);
     UX_ERROR_CHECK(internal_buffer.cr);
 
-    coordinate_t a = coordinate;
+    coordinate_t a = *pcoordinate;
 #if 0
     if(textfill)
       textfill->translate(-a.x,-a.y);
@@ -698,39 +967,38 @@ void uxdevice::textual_render_t::emit(display_context_t &context) {
     a.x = 0;
     a.y = 0;
 
-    fn(internal_buffer.cr, a);
+    fn_render(*this, internal_buffer.cr, a);
     UX_ERROR_CHECK(internal_buffer.cr);
 
     cairo_surface_flush(internal_buffer.rendered);
     UX_ERROR_CHECK(internal_buffer.rendered);
 
-    auto drawfn = [=](display_context_t &context) {
+    auto drawfn = [this, pcoordinate](display_context_t &context) {
       // cairo_set_matrix(context.cr, &mat._matrix);
       drawing_output_t::emit(context);
 
       cairo_set_source_surface(context.cr, internal_buffer.rendered,
-                               coordinate.x, coordinate.y);
+                               pcoordinate->x, pcoordinate->y);
       double tw, th;
-      tw = std::min(ink_rectangle_double.width, coordinate.w);
-      th = std::min(ink_rectangle_double.height, coordinate.h);
+      tw = std::min(ink_rectangle_double.width, pcoordinate->w);
+      th = std::min(ink_rectangle_double.height, pcoordinate->h);
 
       cairo_rectangle(context.cr, ink_rectangle_double.x,
                       ink_rectangle_double.y, tw, th);
       cairo_fill(context.cr);
     };
-    auto fnClipping = [=](display_context_t &context) {
-      auto &coordinate = *unit_memory<coordinate_t>();
+    auto fnClipping = [this, pcoordinate](display_context_t &context) {
       // cairo_set_matrix(context.cr, &mat._matrix);
       drawing_output_t::emit(context);
       cairo_set_source_surface(context.cr, internal_buffer.rendered,
-                               coordinate.x, coordinate.y);
+                               pcoordinate->x, pcoordinate->y);
       cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
                       intersection_double.width, intersection_double.height);
       cairo_fill(context.cr);
     };
     functors_lock(true);
-    fn_draw = std::bind(drawfn, _1);
-    fn_draw_clipped = std::bind(fnClipping, _1);
+    fn_draw = drawfn;
+    fn_draw_clipped = fnClipping;
     functors_lock(false);
     bRenderBufferCached = true;
   };
@@ -738,33 +1006,30 @@ void uxdevice::textual_render_t::emit(display_context_t &context) {
   // the base option rendered contains two functions that rendering using the
   // cairo API to the base surface context. One is for clipping and one
   // without.
-  auto fnBase = [=](display_context_t &context) {
-    auto drawfn = [=](display_context_t &context) {
-      drawing_output_t::emit(context);
-      fn(context.cr, coordinate);
+  auto fnBase = [this, pcoordinate](display_context_t &context) {
+    // the drawing options are applied by the rendering routine.
+    auto drawfn = [this, pcoordinate](display_context_t &context) {
+      fn_render(*this, context.cr, *pcoordinate);
       evaluate_cache(context);
     };
-    auto fnClipping = [=](display_context_t &context) {
+    auto fnClipping = [this, pcoordinate](display_context_t &context) {
       cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
                       intersection_double.width, intersection_double.height);
       cairo_clip(context.cr);
-      drawing_output_t::emit(context);
-      fn(context.cr, coordinate);
+      fn_render(*this, context.cr, *pcoordinate);
       cairo_reset_clip(context.cr);
       evaluate_cache(context);
     };
     functors_lock(true);
-    fn_draw = std::bind(drawfn, _1);
-    fn_draw_clipped = std::bind(fnClipping, _1);
+    fn_draw = drawfn;
+    fn_draw_clipped = fnClipping;
     functors_lock(false);
     if (bRenderBufferCached) {
       context.destroy_buffer(internal_buffer);
       bRenderBufferCached = false;
     }
   };
-  context.lock(true);
-  set_layout_options(context.cr);
-  context.lock(false);
+  request_layout();
   fn_base_surface = fnBase;
   fn_base_surface(context);
 
@@ -776,9 +1041,7 @@ void uxdevice::textual_render_t::emit(display_context_t &context) {
 \brief
 */
 void uxdevice::image_block_t::emit(display_context_t &context) {
-  using namespace std::placeholders;
-
-  if (is_loaded)
+  if (is_loaded || decoded || svg)
     return;
 
   auto coordinate = context.unit_memory<coordinate_t>();
@@ -788,60 +1051,82 @@ void uxdevice::image_block_t::emit(display_context_t &context) {
     const char *s = "An image_block_t object must include the following "
                     "attributes. coordinate_t and an image_block_t name.";
     UX_ERROR_DESC(s);
-    auto fn = [=](display_context_t &context) {};
+    auto fn = [](display_context_t &context) {};
 
-    fn_base_surface = std::bind(fn, _1);
-    fn_cache_surface = std::bind(fn, _1);
-    fn_draw = std::bind(fn, _1);
-    fn_draw_clipped = std::bind(fn, _1);
+    fn_base_surface = fn;
+    fn_cache_surface = fn;
+    fn_draw = fn;
+    fn_draw_clipped = fn;
     return;
   }
 
-  // set the ink area.
+  // set the ink area. the object holds the coordinate, so the pointer the
+  // drawing functions capture stays valid after the context memory or the
+  // display list release it.
+  image_block_storage_t::coordinate = coordinate;
+  coordinate_t *pa = coordinate.get();
   coordinate_t &a = *coordinate;
 
-  auto fnthread = [=, &context, &a]() {
-    image_block_ptr = read_image(description, coordinate->w, coordinate->h);
-
-    if (image_block_ptr) {
-
-      ink_rectangle = {(int)a.x, (int)a.y, (int)a.w, (int)a.h};
-      ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
-                              (double)ink_rectangle.width,
-                              (double)ink_rectangle.height};
-      has_ink_extents = true;
-      is_loaded = true;
-    } else {
-      const char *s = "The image_block_t could not be processed or loaded. ";
-      UX_ERROR_DESC(s);
-      UX_ERROR_DESC(description);
-    }
+  // the coordinate is the area of the image while it is decoded.
+  ink_rectangle = {(int)a.x, (int)a.y, (int)a.w, (int)a.h};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = true;
+
+  // the image is shared through the image cache and decoded by the image
+  // decode threads. When it is ready the area is painted again, at which
+  // time the image is drawn. svg documents are rasterized at the scale they
+  // are drawn, so the area is also painted again when a finer level of the
+  // document is ready. The decode threads reach the context through its
+  // link, as the image may be ready after the context is destroyed.
+  auto link = context.link();
+  cairo_rectangle_int_t r = ink_rectangle;
+  std::string name = description;
+  fn_ready = [link, r, name](cairo_surface_t *image) {
+    link->invoke([&](display_context_t &context) {
+      if (!image) {
+        std::string s = "The image_block_t could not be processed or "
+                        "loaded. ";
+        s += name;
+        UX_ERROR_DESC(s);
+        return;
+      }
+      context.state(r.x, r.y, r.width, r.height);
+      context.state_notify_complete();
+    });
   };
 
-  fnthread();
+  if (svg_image_t::is_svg(description)) {
+    is_SVG = true;
+    svg = svg_image_t::acquire(description, a.w, a.h);
+    svg->request(context.cr, fn_ready);
+  } else {
+    decoded = image_cache_t::acquire(description, a.w, a.h, fn_ready);
+  }
 
-  auto fnCache = [&](display_context_t &context) {
+  auto fnCache = [this, pa](display_context_t &context) {
     // set directly callable rendering function.
-    auto fn = [&](display_context_t &context) {
-      if (!is_valid())
-        return;
+    auto fn = [this, pa](display_context_t &context) {
       drawing_output_t::emit(context);
-      cairo_set_source_surface(context.cr, image_block_ptr, a.x, a.y);
-      cairo_rectangle(context.cr, a.x, a.y, a.w, a.h);
+      if (!set_source(context.cr, pa->x, pa->y))
+        return;
+      cairo_pattern_set_filter(cairo_get_source(context.cr), context.filter());
+      cairo_rectangle(context.cr, pa->x, pa->y, pa->w, pa->h);
       cairo_fill(context.cr);
     };
-    auto fnClipping = [&](display_context_t &context) {
-      if (!is_valid())
-        return;
+    auto fnClipping = [this, pa](display_context_t &context) {
       drawing_output_t::emit(context);
-      cairo_set_source_surface(context.cr, image_block_ptr, a.x, a.y);
+      if (!set_source(context.cr, pa->x, pa->y))
+        return;
+      cairo_pattern_set_filter(cairo_get_source(context.cr), context.filter());
       cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
                       intersection_double.width, intersection_double.height);
       cairo_fill(context.cr);
     };
     functors_lock(true);
-    fn_draw = std::bind(fn, _1);
-    fn_draw_clipped = std::bind(fnClipping, _1);
+    fn_draw = fn;
+    fn_draw_clipped = fnClipping;
     functors_lock(false);
     bRenderBufferCached = true;
   };
@@ -858,6 +1143,922 @@ void uxdevice::image_block_t::emit(display_context_t &context) {
   state_hash_code();
 }
 
+/**
+\internal
+\fn image_view_t::emit
+\brief links the drawing functions. The ink rectangle is the coordinate.
+The area is painted again when the image is opened and when tiles are read.
+*/
+void uxdevice::image_view_t::emit(display_context_t &context) {
+  // create a linkage snapshot to the shared pointers stored in unit memory
+  // within the stream context.
+  copy_unit_memory(context.attributes());
+
+  if (!unit_memory<coordinate_t>() || description.size() == 0) {
+    const char *s = "An image_view_t object must include the following "
+                    "attributes. coordinate_t and an image name.";
+    UX_ERROR_DESC(s);
+    auto fn = [](display_context_t &context) {};
+
+    fn_base_surface = fn;
+    fn_cache_surface = fn;
+    fn_draw = fn;
+    fn_draw_clipped = fn;
+    return;
+  }
+
+  coordinate_t *pa = unit_memory<coordinate_t>().get();
+  ink_rectangle = {(int)pa->x, (int)pa->y, (int)pa->w, (int)pa->h};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = true;
+
+  // read jobs hold the tiles and may complete after the context is
+  // destroyed, so the context is reached through its link.
+  if (!tiles) {
+    auto link = context.link();
+    cairo_rectangle_int_t r = ink_rectangle;
+    std::string name = description;
+    tiles = std::make_shared<image_tiles_t>(
+        description, [link, r, name](bool bRead) {
+          link->invoke([&](display_context_t &context) {
+            if (!bRead) {
+              std::string s = "The image_view_t could not be read in tiles. ";
+              s += name;
+              UX_ERROR_DESC(s);
+              return;
+            }
+            context.state(r.x, r.y, r.width, r.height);
+            context.state_notify_complete();
+          });
+        });
+  }
+
+  auto fnBase = [this, pa](display_context_t &context) {
+    auto drawfn = [this, pa](display_context_t &context) {
+      drawing_output_t::emit(context);
+      render(context, *pa, ink_rectangle_double);
+    };
+    auto fnClipping = [this, pa](display_context_t &context) {
+      drawing_output_t::emit(context);
+      render(context, *pa, intersection_double);
+    };
+    functors_lock(true);
+    fn_draw = drawfn;
+    fn_draw_clipped = fnClipping;
+    functors_lock(false);
+  };
+
+  fn_cache_surface = fnBase;
+  fn_base_surface = fnBase;
+  fn_base_surface(context);
+
+  is_processed = true;
+}
+
+/**
+\internal
+\fn image_view_t::render
+\brief draws the image within the area and the coordinate, placed so that
+the pixel at left, top is at the corner of the coordinate. The tiles are
+scaled with the filter of the frame.
+*/
+void uxdevice::image_view_t::render(display_context_t &context,
+                                    const coordinate_t &a,
+                                    const cairo_rectangle_t &area) {
+  cairo_rectangle_t view = {};
+  view.x = std::max(area.x, a.x);
+  view.y = std::max(area.y, a.y);
+  view.width = std::min(area.x + area.width, a.x + a.w) - view.x;
+  view.height = std::min(area.y + area.height, a.y + a.h) - view.y;
+  if (view.width <= 0 || view.height <= 0)
+    return;
+
+  double z = magnification;
+  tiles->draw(context.cr, a.x - left * z, a.y - top * z, z, view,
+              context.filter());
+}
+
+/**
+\fn image_view_t::scroll
+\param double x, double y - the pixel of the image shown at the top left of
+the view.
+\brief positions the view. Parts of the view beyond the image are not
+drawn.
+*/
+uxdevice::image_view_t &uxdevice::image_view_t::scroll(double x, double y) {
+  left = x;
+  top = y;
+  return *this;
+}
+
+/**
+\fn image_view_t::zoom
+\param double z - user units to a pixel of the image. 1 shows the image at
+its size.
+\brief sets the magnification of the view. The tiles are read at the
+level for the zoom and the scale of the surface.
+*/
+uxdevice::image_view_t &uxdevice::image_view_t::zoom(double z) {
+  if (z > 0)
+    magnification = z;
+  return *this;
+}
+
+/**
+\fn image_view_t::image_size
+\brief the size of the image in pixels, or zero until it has been opened.
+*/
+std::array<int, 2> uxdevice::image_view_t::image_size(void) {
+  return tiles ? tiles->size() : std::array<int, 2>{0, 0};
+}
+
+/**
+\internal
+\fn group_t::emit
+\brief links the drawing functions of the group. Both the normal and
+clipped versions composite the cached layer. The layer is rendered on demand
+when the children of the group have changed.
+*/
+void uxdevice::group_t::emit(display_context_t &context) {
+  group_storage_t::context = &context;
+
+  auto fn = [=](display_context_t &context) { composite(context, false); };
+  auto fnClipping = [=](display_context_t &context) {
+    composite(context, true);
+  };
+
+  functors_lock(true);
+  fn_draw = fn;
+  fn_draw_clipped = fnClipping;
+  functors_lock(false);
+
+  fn_cache_surface = [this](display_context_t &context) {
+    render_layer(context);
+  };
+  fn_base_surface = fn_cache_surface;
+
+  is_processed = true;
+}
+
+/**
+\internal
+\fn group_t::add_drawable
+\brief adds a drawing object to the group display list. Child groups are
+linked to the parent so that damage and bounds are propagated upwards.
+*/
+void uxdevice::group_t::add_drawable(std::shared_ptr<drawing_output_t> _obj) {
+  auto child_group = std::dynamic_pointer_cast<group_t>(_obj);
+  if (child_group)
+    child_group->parent = this;
+
+  GROUP_SPIN;
+  group_display_list.emplace_back(_obj);
+  GROUP_CLEAR;
+
+  _obj->viewport_inked = true;
+}
+
+/**
+\internal
+\fn group_t::update_bounds
+\brief computes the bounds of the group as the union of the ink rectangles
+of the children. The ink rectangle of the group is the bounds translated by
+the group offset, which places it within the coordinate space of the parent.
+Called with the functors of the group locked. The functors of each child are
+locked while its ink rectangle is read, as a child group may be moved from
+the application thread.
+*/
+void uxdevice::group_t::update_bounds(void) {
+  cairo_region_t *rgn = cairo_region_create();
+
+  GROUP_SPIN;
+  for (auto &n : group_display_list) {
+    n->functors_lock(true);
+    if (n->has_ink_extents)
+      cairo_region_union_rectangle(rgn, &n->ink_rectangle);
+    n->functors_lock(false);
+  }
+  GROUP_CLEAR;
+
+  cairo_region_get_extents(rgn, &bounds);
+  cairo_region_destroy(rgn);
+
+  ink_rectangle = {bounds.x + (int)offset_x, bounds.y + (int)offset_y,
+                   bounds.width, bounds.height};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = bounds.width > 0 && bounds.height > 0;
+}
+
+/**
+\internal
+\fn group_t::render_layer
+\brief renders the children of the group into the layer surface. The drawing
+functions of the children are invoked with the context cairo target
+temporarily switched to the layer. The routine is called from the render
+thread while the surface lock is held.
+*/
+void uxdevice::group_t::render_layer(display_context_t &context) {
+  update_bounds();
+  context.destroy_buffer(internal_buffer);
+  bRenderBufferCached = false;
+
+  if (!has_ink_extents)
+    return;
+
+  internal_buffer = context.allocate_buffer(bounds.width, bounds.height);
+  cairo_translate(internal_buffer.cr, -bounds.x, -bounds.y);
+
+  cairo_t *base_cr = context.cr;
+  context.cr = internal_buffer.cr;
+
+  GROUP_SPIN;
+  drawing_output_collection_t children = group_display_list;
+  GROUP_CLEAR;
+
+  for (auto &n : children) {
+    if (!n->has_ink_extents)
+      continue;
+    n->functors_lock(true);
+    if (n->fn_draw)
+      n->fn_draw(context);
+    n->functors_lock(false);
+    n->state_hash_code();
+  }
+
+  context.cr = base_cr;
+
+  cairo_surface_flush(internal_buffer.rendered);
+  UX_ERROR_CHECK(internal_buffer.rendered);
+
+  layer_hash = group_hash_code();
+  bRenderBufferCached = true;
+}
+
+/**
+\internal
+\fn group_t::composite
+\brief paints the cached layer at the ink rectangle using the group opacity.
+*/
+void uxdevice::group_t::composite(display_context_t &context, bool bclipped) {
+  if (!visible)
+    return;
+
+  if (!bRenderBufferCached || layer_hash != group_hash_code())
+    render_layer(context);
+
+  if (!bRenderBufferCached)
+    return;
+
+  drawing_output_t::emit(context);
+  cairo_set_source_surface(context.cr, internal_buffer.rendered,
+                           ink_rectangle_double.x, ink_rectangle_double.y);
+  if (bclipped)
+    cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
+                    intersection_double.width, intersection_double.height);
+  else
+    cairo_rectangle(context.cr, ink_rectangle_double.x, ink_rectangle_double.y,
+                    ink_rectangle_double.width, ink_rectangle_double.height);
+  cairo_clip(context.cr);
+
+  if (alpha >= 1.0)
+    cairo_paint(context.cr);
+  else
+    cairo_paint_with_alpha(context.cr, alpha);
+
+  cairo_reset_clip(context.cr);
+}
+
+/**
+\internal
+\fn group_t::damage
+\brief requests a repaint of the area occupied by the group. The ink
+rectangle is translated by the offsets of the parent groups to surface
+coordinates. Parent bounds are updated because a child group may have moved
+outside of them. The render thread reads the group state while it holds the
+functors lock, so the state of each group is read and changed under that
+lock. Only one lock is held at a time.
+*/
+void uxdevice::group_t::damage(void) {
+  if (!context)
+    return;
+
+  functors_lock(true);
+  bool inked = has_ink_extents;
+  cairo_rectangle_int_t r = ink_rectangle;
+  functors_lock(false);
+
+  if (!inked)
+    return;
+
+  for (group_t *p = parent; p; p = p->parent) {
+    p->functors_lock(true);
+    r.x += (int)p->offset_x;
+    r.y += (int)p->offset_y;
+    p->functors_lock(false);
+  }
+  context->state(r.x, r.y, r.width, r.height);
+
+  if (parent) {
+    parent->functors_lock(true);
+    parent->update_bounds();
+    parent->functors_lock(false);
+    parent->damage();
+  }
+}
+
+/**
+\fn group_t::move
+\param double x
+\param double y
+\brief offsets the group from the location it was drawn at. Only the cached
+layer is recomposited.
+*/
+uxdevice::group_t &uxdevice::group_t::move(double x, double y) {
+  damage();
+  functors_lock(true);
+  offset_x = x;
+  offset_y = y;
+  update_bounds();
+  functors_lock(false);
+  damage();
+  return *this;
+}
+
+/**
+\fn group_t::opacity
+\param double a
+\brief sets the opacity used when compositing the layer, 0.0 to 1.0.
+*/
+uxdevice::group_t &uxdevice::group_t::opacity(double a) {
+  functors_lock(true);
+  alpha = std::clamp(a, 0.0, 1.0);
+  functors_lock(false);
+  damage();
+  return *this;
+}
+
+/**
+\fn group_t::hide
+\brief the group is not composited. The layer is retained.
+*/
+uxdevice::group_t &uxdevice::group_t::hide(void) {
+  functors_lock(true);
+  visible = false;
+  functors_lock(false);
+  damage();
+  return *this;
+}
+
+/**
+\fn group_t::show
+\brief the group layer is composited.
+*/
+uxdevice::group_t &uxdevice::group_t::show(void) {
+  functors_lock(true);
+  visible = true;
+  functors_lock(false);
+  damage();
+  return *this;
+}
+
+namespace {
+/// @brief releases the scratch context of a thread when the thread exits.
+class thread_scratch_context_t {
+public:
+  thread_scratch_context_t()
+      : surface(cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1)),
+        cr(cairo_create(surface)) {}
+  ~thread_scratch_context_t() {
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+  }
+  cairo_surface_t *surface = nullptr;
+  cairo_t *cr = nullptr;
+};
+} // namespace
+
+/**
+\internal
+\fn recording_scratch_context
+\brief a cairo context private to the calling thread. It is used to compute
+the extents of recorded paths without touching the surface context. Path
+and stroke extents do not depend upon the target surface size.
+*/
+static cairo_t *recording_scratch_context(void) {
+  static thread_local thread_scratch_context_t scratch = {};
+  return scratch.cr;
+}
+
+/**
+\internal
+\fn recorded_path_t::emit
+\brief completes the recording. The line attributes in effect within the
+context are captured so the path replays the same on the render thread. The
+extents are computed by replaying the path on the scratch context. A
+painting operation that is not bounded by the path, such as paint, uses the
+whole surface.
+*/
+void uxdevice::recorded_path_t::emit(display_context_t &context) {
+  auto snapshot = [&](auto attribute) {
+    if (attribute)
+      attributes.emplace_back(
+          [attribute](cairo_t *cr) { attribute->emit(cr); });
+  };
+  snapshot(context.unit_memory<antialias_t>());
+  snapshot(context.unit_memory<line_width_t>());
+  snapshot(context.unit_memory<line_cap_t>());
+  snapshot(context.unit_memory<line_join_t>());
+  snapshot(context.unit_memory<miter_limit_t>());
+  snapshot(context.unit_memory<line_dashes_t>());
+  snapshot(context.unit_memory<tollerance_t>());
+  snapshot(context.unit_memory<graphic_operator_t>());
+
+  cairo_rectangle_t r = {0, 0, (double)context.window_width,
+                         (double)context.window_height};
+  cairo_t *cr = recording_scratch_context();
+  cairo_save(cr);
+  cairo_new_path(cr);
+  recorded_path_storage_t::replay(cr);
+  if (!extents || !extents(cr, r))
+    r = {0, 0, (double)context.window_width, (double)context.window_height};
+  cairo_new_path(cr);
+  cairo_restore(cr);
+
+  // expand to whole pixels and include the antialiasing edge.
+  ink_rectangle = {(int)std::floor(r.x) - 1, (int)std::floor(r.y) - 1,
+                   (int)std::ceil(r.width) + 2, (int)std::ceil(r.height) + 2};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = r.width > 0 && r.height > 0;
+
+  auto fn = [=](display_context_t &context) { replay(context, false); };
+  auto fnClipping = [=](display_context_t &context) {
+    replay(context, true);
+  };
+
+  functors_lock(true);
+  fn_draw = fn;
+  fn_draw_clipped = fnClipping;
+  functors_lock(false);
+
+  fn_base_surface = [=](display_context_t &context) {
+    functors_lock(true);
+    fn_draw = fn;
+    fn_draw_clipped = fnClipping;
+    functors_lock(false);
+    if (bRenderBufferCached) {
+      context.destroy_buffer(internal_buffer);
+      bRenderBufferCached = false;
+    }
+  };
+  fn_cache_surface = [this](display_context_t &context) {
+    render_cache(context);
+  };
+
+  is_processed = true;
+  state_hash_code();
+}
+
+/**
+\internal
+\fn recorded_path_t::replay
+\brief issues the recorded calls on the surface context. The cairo state is
+saved so the recorded attributes do not affect objects drawn afterwards.
+*/
+void uxdevice::recorded_path_t::replay(display_context_t &context,
+                                       bool bclipped) {
+  cairo_save(context.cr);
+  if (bclipped) {
+    cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
+                    intersection_double.width, intersection_double.height);
+    cairo_clip(context.cr);
+  }
+  drawing_output_t::emit(context);
+  cairo_new_path(context.cr);
+  recorded_path_storage_t::replay(context.cr);
+  if (paint)
+    paint(context.cr);
+  cairo_restore(context.cr);
+}
+
+/**
+\internal
+\fn recorded_path_t::render_cache
+\brief renders the path once into an off screen buffer the size of the ink
+rectangle. The drawing functions then paint the buffer.
+*/
+void uxdevice::recorded_path_t::render_cache(display_context_t &context) {
+  if (bRenderBufferCached || !has_ink_extents)
+    return;
+
+  internal_buffer =
+      context.allocate_buffer(ink_rectangle.width, ink_rectangle.height);
+  cairo_translate(internal_buffer.cr, -ink_rectangle_double.x,
+                  -ink_rectangle_double.y);
+  for (auto &fn : options.value)
+    fn(internal_buffer.cr);
+  recorded_path_storage_t::replay(internal_buffer.cr);
+  if (paint)
+    paint(internal_buffer.cr);
+  cairo_surface_flush(internal_buffer.rendered);
+  UX_ERROR_CHECK(internal_buffer.rendered);
+
+  auto drawfn = [=](display_context_t &context) {
+    cairo_set_source_surface(context.cr, internal_buffer.rendered,
+                             ink_rectangle_double.x, ink_rectangle_double.y);
+    cairo_rectangle(context.cr, ink_rectangle_double.x, ink_rectangle_double.y,
+                    ink_rectangle_double.width, ink_rectangle_double.height);
+    cairo_fill(context.cr);
+  };
+  auto fnClipping = [=](display_context_t &context) {
+    cairo_set_source_surface(context.cr, internal_buffer.rendered,
+                             ink_rectangle_double.x, ink_rectangle_double.y);
+    cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
+                    intersection_double.width, intersection_double.height);
+    cairo_fill(context.cr);
+  };
+  functors_lock(true);
+  fn_draw = drawfn;
+  fn_draw_clipped = fnClipping;
+  functors_lock(false);
+  bRenderBufferCached = true;
+}
+
+/**
+\internal
+\fn text_view_t::emit
+\brief starts indexing the lines of the text and links the drawing
+functions. The ink rectangle is the coordinate. The area is repainted each
+time a batch of lines is indexed, so lines appear as the scan proceeds.
+*/
+void uxdevice::text_view_t::emit(display_context_t &context) {
+  // create a linkage snapshot to the shared pointers stored in unit memory
+  // within the stream context.
+  copy_unit_memory(context.attributes());
+
+  if (!(line_index && line_index->is_valid() &&
+        unit_memory<coordinate_t>() && unit_memory<text_font_t>() &&
+        unit_memory<text_color_t>())) {
+    const char *s =
+        "A text_view_t object must include a file that can be mapped or a "
+        "text buffer. As well, a coordinate_t, text_font_t and text_color_t.";
+    UX_ERROR_DESC(s);
+    auto fn = [](display_context_t &context) {};
+
+    fn_base_surface = fn;
+    fn_cache_surface = fn;
+    fn_draw = fn;
+    fn_draw_clipped = fn;
+    return;
+  }
+
+  coordinate_t *pa = unit_memory<coordinate_t>().get();
+  ink_rectangle = {(int)pa->x, (int)pa->y, (int)pa->w, (int)pa->h};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = true;
+
+  // the scan thread reaches the context through its link.
+  auto link = context.link();
+  cairo_rectangle_int_t r = ink_rectangle;
+  line_index->scan([link, r](std::size_t lines) {
+    link->invoke([&](display_context_t &context) {
+      context.state(r.x, r.y, r.width, r.height);
+      context.state_notify_complete();
+    });
+  });
+
+  auto fnBase = [this, pa](display_context_t &context) {
+    auto drawfn = [this, pa](display_context_t &context) {
+      drawing_output_t::emit(context);
+      render(context.cr, *pa);
+    };
+    auto fnClipping = [this, pa](display_context_t &context) {
+      cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
+                      intersection_double.width, intersection_double.height);
+      cairo_clip(context.cr);
+      drawing_output_t::emit(context);
+      render(context.cr, *pa);
+      cairo_reset_clip(context.cr);
+    };
+    functors_lock(true);
+    fn_draw = drawfn;
+    fn_draw_clipped = fnClipping;
+    functors_lock(false);
+  };
+
+  fn_cache_surface = fnBase;
+  fn_base_surface = fnBase;
+  fn_base_surface(context);
+
+  is_processed = true;
+}
+
+/**
+\internal
+\fn text_view_t::layout_window
+\brief shapes the lines from the top line less the margin through the last
+line in view plus the margin. Lines already within the window keep their
+layout. Others are obtained from the text layout cache. The height of a line
+is the logical height of an empty layout in the font.
+*/
+void uxdevice::text_view_t::layout_window(const coordinate_t &a) {
+  auto font = unit_memory<text_font_t>();
+
+  auto shape = [&](const std::string_view &text) {
+    text_layout_key_t key = {};
+    key.text_hash = std::hash<std::string_view>{}(text);
+    key.text = text;
+    key.font_description = font->description;
+    return text_layout_cache_t::acquire(key, [&](PangoLayout *l) {
+      font->emit(l);
+      pango_layout_set_text(l, text.data(), static_cast<int>(text.size()));
+    });
+  };
+
+  line_height = std::max(shape(std::string_view())->logical_rect.height, 1);
+
+  std::size_t count = line_index->line_count();
+  std::size_t top = std::min(top_line.load(), count ? count - 1 : 0);
+  std::size_t visible = static_cast<std::size_t>(a.h / line_height) + 1;
+  std::size_t first = top > margin_lines ? top - margin_lines : 0;
+  std::size_t last = std::min(count, top + visible + margin_lines);
+
+  if (first == window_line && window.size() == last - first)
+    return;
+
+  std::vector<text_layout_cache_t::text_layout_ptr_t> shaped = {};
+  shaped.reserve(last - first);
+  for (std::size_t n = first; n < last; n++) {
+    if (n >= window_line && n < window_line + window.size()) {
+      shaped.emplace_back(window[n - window_line]);
+      continue;
+    }
+
+    // very long lines are shortened at a character boundary.
+    std::string_view text = line_index->line(n);
+    if (text.size() > line_limit) {
+      std::size_t length = line_limit;
+      while (length > 0 && (text[length] & 0xC0) == 0x80)
+        length--;
+      text = text.substr(0, length);
+    }
+    shaped.emplace_back(shape(text));
+  }
+
+  window = std::move(shaped);
+  window_line = first;
+}
+
+/**
+\internal
+\fn text_view_t::render
+\brief draws the lines of the window that are within the coordinate. The
+position of a line follows from its number and the line height.
+*/
+void uxdevice::text_view_t::render(cairo_t *cr, coordinate_t &a) {
+  layout_window(a);
+
+  std::size_t count = line_index->line_count();
+  double top = static_cast<double>(std::min(top_line.load(), count));
+
+  cairo_save(cr);
+  cairo_rectangle(cr, a.x, a.y, a.w, a.h);
+  cairo_clip(cr);
+  unit_memory<text_color_t>()->emit(cr, a);
+
+  for (std::size_t i = 0; i < window.size(); i++) {
+    double y =
+        a.y + (static_cast<double>(window_line + i) - top) * line_height;
+    if (y + line_height < a.y || y > a.y + a.h)
+      continue;
+    cairo_move_to(cr, a.x, y);
+    window[i]->show(cr);
+  }
+  cairo_restore(cr);
+}
+
+/**
+\fn text_view_t::scroll
+\param std::size_t line - the line shown at the top of the view.
+\brief positions the view. Lines beyond the text are limited to the last
+line when drawn.
+*/
+uxdevice::text_view_t &uxdevice::text_view_t::scroll(std::size_t line) {
+  top_line = line;
+  return *this;
+}
+
+/**
+\fn text_view_t::line_count
+\brief the number of lines indexed so far.
+*/
+std::size_t uxdevice::text_view_t::line_count(void) {
+  return line_index ? line_index->line_count() : 0;
+}
+
+/**
+\internal
+\fn text_console_t::emit
+\brief links the drawing functions. The ink rectangle is the coordinate.
+Lines appended afterwards request a repaint of the coordinate through the
+context.
+*/
+void uxdevice::text_console_t::emit(display_context_t &context) {
+  // create a linkage snapshot to the shared pointers stored in unit memory
+  // within the stream context.
+  copy_unit_memory(context.attributes());
+
+  if (!(buffer && unit_memory<coordinate_t>() && unit_memory<text_font_t>() &&
+        unit_memory<text_color_t>())) {
+    const char *s = "A text_console_t object must be created with the number "
+                    "of lines to retain. As well, a coordinate_t, text_font_t "
+                    "and text_color_t.";
+    UX_ERROR_DESC(s);
+    auto fn = [](display_context_t &context) {};
+
+    fn_base_surface = fn;
+    fn_cache_surface = fn;
+    fn_draw = fn;
+    fn_draw_clipped = fn;
+    return;
+  }
+
+  coordinate_t *pa = unit_memory<coordinate_t>().get();
+  ink_rectangle = {(int)pa->x, (int)pa->y, (int)pa->w, (int)pa->h};
+  ink_rectangle_double = {(double)ink_rectangle.x, (double)ink_rectangle.y,
+                          (double)ink_rectangle.width,
+                          (double)ink_rectangle.height};
+  has_ink_extents = true;
+  this->context = &context;
+
+  auto fnBase = [this, pa](display_context_t &context) {
+    auto drawfn = [this, pa](display_context_t &context) {
+      drawing_output_t::emit(context);
+      render(context.cr, *pa);
+    };
+    auto fnClipping = [this, pa](display_context_t &context) {
+      cairo_rectangle(context.cr, intersection_double.x, intersection_double.y,
+                      intersection_double.width, intersection_double.height);
+      cairo_clip(context.cr);
+      drawing_output_t::emit(context);
+      render(context.cr, *pa);
+      cairo_reset_clip(context.cr);
+    };
+    functors_lock(true);
+    fn_draw = drawfn;
+    fn_draw_clipped = fnClipping;
+    functors_lock(false);
+  };
+
+  fn_cache_surface = fnBase;
+  fn_base_surface = fnBase;
+  fn_base_surface(context);
+
+  is_processed = true;
+}
+
+/**
+\internal
+\fn text_console_t::update_surface
+\brief takes the lines appended since the last update and draws them upon
+the surface. When the view scrolls by fewer lines than it shows, the pixels
+of the lines already drawn are moved up and only the new lines are shaped.
+The surface is drawn again entirely when the coordinate, font or color
+changes. The surface is in the user space of the coordinate so brushes are
+positioned as they are for other text.
+*/
+void uxdevice::text_console_t::update_surface(coordinate_t &a) {
+  auto font = unit_memory<text_font_t>();
+  auto color = unit_memory<text_color_t>();
+  int width = std::max(static_cast<int>(std::ceil(a.w)), 1);
+  int height = std::max(static_cast<int>(std::ceil(a.h)), 1);
+
+  std::size_t hash = {};
+  hash_combine(hash, width, height, a.x, a.y, font->hash_code(),
+               color->hash_code());
+
+  std::size_t added = buffer->take();
+  bool bRedraw = !surface || hash != surface_hash;
+  if (!bRedraw && !added)
+    return;
+
+  if (bRedraw) {
+    release_surface();
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cr = cairo_create(surface);
+    cairo_translate(cr, -a.x, -a.y);
+    layout = pango_cairo_create_layout(cr);
+    font->emit(layout);
+
+    PangoRectangle logical_rect = PangoRectangle();
+    pango_layout_set_text(layout, "", 0);
+    pango_layout_get_pixel_extents(layout, nullptr, &logical_rect);
+    line_height = std::max(logical_rect.height, 1);
+    surface_hash = hash;
+  }
+
+  // the most recent lines that fit entirely are shown.
+  std::size_t rows = std::max(static_cast<std::size_t>(height / line_height),
+                              std::size_t{1});
+  std::size_t total = buffer->total();
+  std::size_t top = total > rows ? total - rows : 0;
+  std::size_t first = bRedraw ? top : std::max(total - added, top);
+
+  if (bRedraw || top >= surface_line + rows) {
+    first = top;
+  } else if (top > surface_line) {
+    // move the pixels of the lines still shown up within the surface.
+    int dy = static_cast<int>(top - surface_line) * line_height;
+    int stride = cairo_image_surface_get_stride(surface);
+    unsigned char *data = cairo_image_surface_get_data(surface);
+    cairo_surface_flush(surface);
+    std::memmove(data, data + static_cast<std::size_t>(dy) * stride,
+                 static_cast<std::size_t>(height - dy) * stride);
+    cairo_surface_mark_dirty(surface);
+  }
+  surface_line = top;
+
+  // lines discarded by the ring are left blank.
+  first = std::max(first, total - buffer->size());
+
+  double y = a.y + static_cast<double>(first - top) * line_height;
+  cairo_save(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+  cairo_rectangle(cr, a.x, y, width, a.y + height - y);
+  cairo_fill(cr);
+  cairo_restore(cr);
+
+  color->emit(cr, a);
+  for (std::size_t n = first; n < total; n++, y += line_height) {
+    // very long lines are shortened at a character boundary.
+    std::string_view text = buffer->line(n);
+    if (text.size() > line_limit) {
+      std::size_t length = line_limit;
+      while (length > 0 && (text[length] & 0xC0) == 0x80)
+        length--;
+      text = text.substr(0, length);
+    }
+    pango_layout_set_text(layout, text.data(), static_cast<int>(text.size()));
+    cairo_move_to(cr, a.x, y);
+    pango_cairo_show_layout(cr, layout);
+  }
+}
+
+/**
+\internal
+\fn text_console_t::render
+\brief brings the surface up to date and paints it at the coordinate.
+*/
+void uxdevice::text_console_t::render(cairo_t *cr, coordinate_t &a) {
+  update_surface(a);
+
+  cairo_save(cr);
+  cairo_rectangle(cr, a.x, a.y, a.w, a.h);
+  cairo_clip(cr);
+  cairo_set_source_surface(cr, surface, a.x, a.y);
+  cairo_paint(cr);
+  cairo_restore(cr);
+}
+
+/**
+\fn text_console_t::append
+\param const std::string_view &text - one or more lines separated by new
+line characters.
+\brief adds lines to the console. May be called from any thread. The first
+append after the console is drawn requests a repaint, later ones are drawn
+with it.
+*/
+uxdevice::text_console_t &
+uxdevice::text_console_t::append(const std::string_view &text) {
+  if (!buffer)
+    return *this;
+
+  if (buffer->append(text)) {
+    display_context_t *pcontext = context;
+    if (pcontext) {
+      pcontext->state(ink_rectangle.x, ink_rectangle.y, ink_rectangle.width,
+                      ink_rectangle.height);
+      pcontext->state_notify_complete();
+    }
+  }
+  return *this;
+}
+
+/**
+\fn text_console_t::line_count
+\brief the number of lines drawn so far, including those no longer retained.
+*/
+std::size_t uxdevice::text_console_t::line_count(void) {
+  return buffer ? buffer->total() : 0;
+}
+
 /**
 \internal
 \class function_object_t
@@ -888,8 +2089,6 @@ void uxdevice::cairo_option_function_t::emit(cairo_t *cr) {
 \brief
 */
 void uxdevice::draw_function_object_t::emit(display_context_t &context) {
-  using namespace std::placeholders;
-
   // get the drawing options for the context.
   auto options = context.unit_memory<cairo_option_function_t>();
 
@@ -913,8 +2112,8 @@ void uxdevice::draw_function_object_t::emit(display_context_t &context) {
     };
 
     functors_lock(true);
-    fn_draw = std::bind(fn, _1);
-    fn_draw_clipped = std::bind(fnClipping, _1);
+    fn_draw = fn;
+    fn_draw_clipped = fnClipping;
     functors_lock(false);
     bRenderBufferCached = true;
   };
@@ -1178,6 +2377,12 @@ void uxdevice::stroke_path_t::emit(cairo_t *cr) {
   painter_brush_t::emit(cr);
   cairo_stroke(cr);
 }
+bool uxdevice::stroke_path_t::path_extents(cairo_t *cr, cairo_rectangle_t &r) {
+  double x1, y1, x2, y2;
+  cairo_stroke_extents(cr, &x1, &y1, &x2, &y2);
+  r = {x1, y1, x2 - x1, y2 - y1};
+  return true;
+}
 
 /**
 
@@ -1192,6 +2397,12 @@ void uxdevice::fill_path_t::emit(cairo_t *cr) {
   painter_brush_t::emit(cr);
   cairo_fill(cr);
 }
+bool uxdevice::fill_path_t::path_extents(cairo_t *cr, cairo_rectangle_t &r) {
+  double x1, y1, x2, y2;
+  cairo_fill_extents(cr, &x1, &y1, &x2, &y2);
+  r = {x1, y1, x2 - x1, y2 - y1};
+  return true;
+}
 
 /**
 
@@ -1208,6 +2419,14 @@ void uxdevice::stroke_fill_path_t::emit(cairo_t *cr) {
   fill_brush.emit(cr);
   cairo_fill(cr);
 }
+bool uxdevice::stroke_fill_path_t::path_extents(cairo_t *cr,
+                                                cairo_rectangle_t &r) {
+  // the stroke extents include the interior of the path.
+  double x1, y1, x2, y2;
+  cairo_stroke_extents(cr, &x1, &y1, &x2, &y2);
+  r = {x1, y1, x2 - x1, y2 - y1};
+  return true;
+}
 
 /**
 
@@ -1219,6 +2438,9 @@ void uxdevice::stroke_fill_path_t::emit(cairo_t *cr) {
 
  */
 void uxdevice::mask_t::emit(cairo_t *cr) {}
+bool uxdevice::mask_t::path_extents(cairo_t *cr, cairo_rectangle_t &r) {
+  return false;
+}
 
 /**
 
@@ -1236,6 +2458,9 @@ void uxdevice::paint_t::emit(cairo_t *cr) {
     cairo_paint_with_alpha(cr, value);
   }
 }
+bool uxdevice::paint_t::path_extents(cairo_t *cr, cairo_rectangle_t &r) {
+  return false;
+}
 /**
 
 \class relative_coordinate_t
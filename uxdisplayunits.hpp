@@ -338,6 +338,9 @@ public:
     is_SVG = other.is_SVG;
     is_loaded = other.is_loaded;
     coordinate = std::move(other.coordinate);
+    decoded = std::move(other.decoded);
+    svg = std::move(other.svg);
+    fn_ready = std::move(other.fn_ready);
     return *this;
   }
 
@@ -348,6 +351,9 @@ public:
     is_SVG = other.is_SVG;
     is_loaded = other.is_loaded;
     coordinate = other.coordinate;
+    decoded = other.decoded;
+    svg = other.svg;
+    fn_ready = other.fn_ready;
     return *this;
   }
 
@@ -356,14 +362,17 @@ public:
       : description(std::move(other.description)),
         image_block_ptr(std::move(other.image_block_ptr)),
         is_SVG(std::move(other.is_SVG)), is_loaded(std::move(other.is_loaded)),
-        coordinate(std::move(other.coordinate)) {}
+        coordinate(std::move(other.coordinate)),
+        decoded(std::move(other.decoded)), svg(std::move(other.svg)),
+        fn_ready(std::move(other.fn_ready)) {}
 
   /// @brief copy constructor
   image_block_storage_t(const image_block_storage_t &other)
       : description(other.description),
         image_block_ptr(cairo_surface_reference(other.image_block_ptr)),
         is_SVG(other.is_SVG), is_loaded(other.is_loaded),
-        coordinate(other.coordinate) {}
+        coordinate(other.coordinate), decoded(other.decoded),
+        svg(other.svg), fn_ready(other.fn_ready) {}
 
   virtual ~image_block_storage_t() {
     if (image_block_ptr)
@@ -372,6 +381,29 @@ public:
 
   bool is_valid(void) { return image_block_ptr != nullptr; }
 
+  /// @brief takes the image from the decode threads once it is ready.
+  /// Returns true when there is an image to draw.
+  bool image_ready(void) {
+    if (!image_block_ptr && decoded && decoded->is_ready()) {
+      if (decoded->image)
+        image_block_ptr = cairo_surface_reference(decoded->image);
+      decoded.reset();
+      is_loaded = image_block_ptr != nullptr;
+    }
+    return is_valid();
+  }
+
+  /// @brief sets the source of the cairo context to the image placed at x,
+  /// y. Returns false when there is no image to draw.
+  bool set_source(cairo_t *cr, double x, double y) {
+    if (svg)
+      return svg->set_source(cr, x, y, fn_ready);
+    if (!image_ready())
+      return false;
+    cairo_set_source_surface(cr, image_block_ptr, x, y);
+    return true;
+  }
+
   std::size_t hash_code(void) const noexcept {
     std::size_t __value = {};
     hash_combine(__value, std::type_index(typeid(image_block_storage_t)),
@@ -385,10 +417,95 @@ public:
   bool is_SVG = {};
   bool is_loaded = {};
   std::shared_ptr<coordinate_t> coordinate = {};
+
+  // the image while it is decoded.
+  image_cache_t::decoded_image_ptr_t decoded = {};
+
+  // an svg document, drawn at the resolution of the surface.
+  svg_image_t::svg_image_ptr_t svg = {};
+
+  // paints the area again when an image or a level of the svg is ready.
+  image_cache_t::image_ready_t fn_ready = {};
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::image_block_storage_t);
 
+/**
+\internal
+\class image_view_storage_t
+\brief storage for an image view. The image is held by image tiles, which
+read the tiles in view as they are drawn. The position and zoom of the view
+may be changed from any thread.
+
+\details the tiles are private to each object and are created when it is
+first emitted.
+
+ */
+namespace uxdevice {
+class image_view_storage_t : virtual public hash_members_t,
+                             public unit_memory_storage_t {
+public:
+  image_view_storage_t() {}
+  image_view_storage_t(const std::string &_description)
+      : description(_description) {}
+
+  /// @brief copy constructor
+  image_view_storage_t(const image_view_storage_t &other)
+      : unit_memory_storage_t(other), description(other.description),
+        left(other.left.load()), top(other.top.load()),
+        magnification(other.magnification.load()) {}
+
+  /// @brief move constructor
+  image_view_storage_t(image_view_storage_t &&other) noexcept
+      : unit_memory_storage_t(other),
+        description(std::move(other.description)),
+        tiles(std::move(other.tiles)), left(other.left.load()),
+        top(other.top.load()), magnification(other.magnification.load()) {}
+
+  /// @brief copy assignment operator
+  image_view_storage_t &operator=(const image_view_storage_t &other) {
+    unit_memory_storage_t::operator=(other);
+    description = other.description;
+    tiles.reset();
+    left = other.left.load();
+    top = other.top.load();
+    magnification = other.magnification.load();
+    return *this;
+  }
+
+  /// @brief move assignment
+  image_view_storage_t &operator=(image_view_storage_t &&other) noexcept {
+    unit_memory_storage_t::operator=(other);
+    description = std::move(other.description);
+    tiles = std::move(other.tiles);
+    left = other.left.load();
+    top = other.top.load();
+    magnification = other.magnification.load();
+    return *this;
+  }
+
+  virtual ~image_view_storage_t() {}
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, std::type_index(typeid(image_view_storage_t)),
+                 description, left.load(), top.load(), magnification.load(),
+                 unit_memory<coordinate_t>());
+    return __value;
+  }
+
+  std::string description = {};
+  image_tiles_t::image_tiles_ptr_t tiles = {};
+
+  // the pixel of the image at the top left of the view, and the user units
+  // to a pixel of the image.
+  std::atomic<double> left = {};
+  std::atomic<double> top = {};
+  std::atomic<double> magnification = {1};
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::image_view_storage_t);
+
 /**
 \internal
 \class text_font_data_storage
@@ -405,7 +522,8 @@ public:
   // these become public members of the base class.
   text_font_storage_t() : description{}, font_ptr(nullptr) {}
   text_font_storage_t(const std::string &_description)
-      : description(_description), font_ptr(nullptr) {}
+      : description(_description),
+        font_ptr(font_registry_t::description(_description)) {}
 
   /// @brief move constructor
   text_font_storage_t(text_font_storage_t &&other) noexcept
@@ -413,30 +531,31 @@ public:
 
   /// @brief copy constructor
   text_font_storage_t(const text_font_storage_t &other)
-      : description(other.description), font_ptr(nullptr) {}
+      : description(other.description), font_ptr(other.font_ptr) {}
 
-  virtual ~text_font_storage_t() {
-    if (font_ptr)
-      pango_font_description_free(font_ptr);
-  }
+  virtual ~text_font_storage_t() {}
 
   text_font_storage_t &operator=(const text_font_storage_t &&other) noexcept {
     description = other.description;
+    font_ptr = other.font_ptr;
     return *this;
   }
   text_font_storage_t &operator=(const text_font_storage_t &other) {
     description = other.description;
+    font_ptr = other.font_ptr;
     return *this;
   }
 
   text_font_storage_t &operator=(const std::string &_desc) {
     description = _desc;
+    font_ptr = font_registry_t::description(description);
     return *this;
   }
 
   /// @brief move assignment
   text_font_storage_t &operator=(const std::string &&_desc) noexcept {
     description = _desc;
+    font_ptr = font_registry_t::description(description);
     return *this;
   }
 
@@ -449,7 +568,9 @@ public:
   }
 
   std::string description = {};
-  PangoFontDescription *font_ptr = {};
+
+  /// @brief parsed description owned by the font registry.
+  const PangoFontDescription *font_ptr = {};
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_font_storage_t);
@@ -469,41 +590,63 @@ class textual_render_storage_t : virtual public drawing_output_t,
                                  virtual public hash_members_t,
                                  public unit_memory_storage_t {
 public:
-  typedef std::function<void(cairo_t *cr, const coordinate_t &a)>
-      internal_cairo_function_t;
-  textual_render_storage_t() {}
+  /// @brief the way the glyphs are painted. color and atlas paint with the
+  /// text_color_t. The others paint the outline path of the text.
+  enum class text_paint_t { color, atlas, fill, outline, fill_outline };
 
-  virtual ~textual_render_storage_t() {
-    if (shadow_image)
-      cairo_surface_destroy(shadow_image);
-
-    if (shadow_cr)
-      cairo_destroy(shadow_cr);
+  /// @brief a drawing routine specialized for one combination of the text
+  /// rendering attributes.
+  typedef void (*text_render_function_t)(textual_render_storage_t &text,
+                                         cairo_t *cr, coordinate_t &a);
+  textual_render_storage_t() {}
 
-    if (layout)
-      g_object_unref(layout);
-  }
+  virtual ~textual_render_storage_t() {}
 
   /// @brief move constructor
   textual_render_storage_t(textual_render_storage_t &&other) noexcept
-      : shadow_image(other.shadow_image), shadow_cr(other.shadow_cr),
-        layout(other.layout), ink_rect(other.ink_rect),
+      : shadow(std::move(other.shadow)), shadow_key(other.shadow_key),
+        context(other.context), layout(other.layout),
+        shaped_layout(std::move(other.shaped_layout)),
+        layout_key(std::move(other.layout_key)),
+        layout_data(std::move(other.layout_data)),
+        layout_attributes(other.layout_attributes),
+        shadow_layout_current(other.shadow_layout_current),
+        pending_layout(std::move(other.pending_layout)),
+        pending_key(std::move(other.pending_key)),
+        interactive_layout(std::move(other.interactive_layout)),
+        interactive_source(other.interactive_source),
+        paragraphs(std::move(other.paragraphs)), ink_rect(other.ink_rect),
         logical_rect(other.logical_rect), matrix(other.matrix) {}
 
   /// @brief copy constructor
   textual_render_storage_t(const textual_render_storage_t &other)
-      : shadow_image(cairo_surface_reference(other.shadow_image)),
-        shadow_cr(cairo_reference(other.shadow_cr)), ink_rect(other.ink_rect),
-        logical_rect(other.logical_rect), matrix(other.matrix) {
-    if (other.layout)
-      layout = pango_layout_copy(other.layout);
-  }
+      : shadow(other.shadow), shadow_key(other.shadow_key),
+        context(other.context), layout(other.layout),
+        shaped_layout(other.shaped_layout), layout_key(other.layout_key),
+        layout_data(other.layout_data),
+        layout_attributes(other.layout_attributes),
+        shadow_layout_current(other.shadow_layout_current),
+        pending_layout(other.pending_layout), pending_key(other.pending_key),
+        interactive_layout(other.interactive_layout),
+        interactive_source(other.interactive_source),
+        paragraphs(other.paragraphs), ink_rect(other.ink_rect),
+        logical_rect(other.logical_rect), matrix(other.matrix) {}
 
   textual_render_storage_t &operator=(const textual_render_storage_t &other) {
-    shadow_image = cairo_surface_reference(other.shadow_image);
-    shadow_cr = cairo_reference(other.shadow_cr);
-    if (other.layout)
-      layout = pango_layout_copy(other.layout);
+    shadow = other.shadow;
+    shadow_key = other.shadow_key;
+    context = other.context;
+    layout = other.layout;
+    shaped_layout = other.shaped_layout;
+    layout_key = other.layout_key;
+    layout_data = other.layout_data;
+    layout_attributes = other.layout_attributes;
+    shadow_layout_current = other.shadow_layout_current;
+    pending_layout = other.pending_layout;
+    pending_key = other.pending_key;
+    interactive_layout = other.interactive_layout;
+    interactive_source = other.interactive_source;
+    paragraphs = other.paragraphs;
     ink_rect = other.ink_rect;
     logical_rect = other.logical_rect;
     matrix = other.matrix;
@@ -512,9 +655,20 @@ public:
 
   textual_render_storage_t &
   operator=(const textual_render_storage_t &&other) noexcept {
-    shadow_image = other.shadow_image;
-    shadow_cr = other.shadow_cr;
+    shadow = other.shadow;
+    shadow_key = other.shadow_key;
+    context = other.context;
     layout = other.layout;
+    shaped_layout = other.shaped_layout;
+    layout_key = other.layout_key;
+    layout_data = other.layout_data;
+    layout_attributes = other.layout_attributes;
+    shadow_layout_current = other.shadow_layout_current;
+    pending_layout = other.pending_layout;
+    pending_key = other.pending_key;
+    interactive_layout = other.interactive_layout;
+    interactive_source = other.interactive_source;
+    paragraphs = other.paragraphs;
     ink_rect = other.ink_rect;
     logical_rect = other.logical_rect;
     matrix = other.matrix;
@@ -523,16 +677,63 @@ public:
 
   std::size_t hash_code(void) const noexcept;
 
-  cairo_surface_t *shadow_image = nullptr;
-  cairo_t *shadow_cr = nullptr;
+  // the blurred shadow is shared through the text shadow cache. The context
+  // is repainted when a shadow being blurred becomes ready.
+  text_shadow_cache_t::shadow_image_ptr_t shadow = {};
+  text_shadow_key_t shadow_key = {};
+  display_context_t *context = nullptr;
+
+  // the layout is shared through the text layout cache and is not changed.
+  // text that may be edited after insertion is laid out by paragraph.
   PangoLayout *layout = nullptr;
+  text_layout_cache_t::text_layout_ptr_t shaped_layout = {};
+  text_layout_key_t layout_key = {};
+  // the text and the hash of the layout attributes the key was made from.
+  // The key is made again only when either changes, and the shadow is keyed
+  // again only when the key has changed.
+  std::shared_ptr<text_data_t> layout_data = {};
+  std::size_t layout_attributes = {};
+  bool shadow_layout_current = false;
+  text_layout_cache_t::text_layout_future_t pending_layout = {};
+  text_layout_key_t pending_key = {};
+
+  // the layout shaped with gray antialiasing for interactive frames, and the
+  // layout it was requested for.
+  text_layout_cache_t::text_layout_future_t interactive_layout = {};
+  const text_layout_t *interactive_source = nullptr;
+  paragraph_layout_t paragraphs = {};
   PangoRectangle ink_rect = PangoRectangle();
   PangoRectangle logical_rect = PangoRectangle();
   matrix_t matrix = {};
 
+  // the drawing routine and the brushes it paints with are resolved once
+  // when the text is inserted.
+  text_render_function_t fn_render = nullptr;
+  text_color_t *render_color = nullptr;
+  text_fill_t *render_fill = nullptr;
+  text_outline_t *render_outline = nullptr;
+  text_shadow_t *render_shadow = nullptr;
+
   bool set_layout_options(cairo_t *cr);
-  void create_shadow(void);
-  internal_cairo_function_t precise_rendering_function(void);
+  void request_layout(void);
+  static void layout_options(const unit_memory_storage_t &memory,
+                             PangoLayout *l);
+  static void layout_text(const unit_memory_storage_t &memory,
+                          PangoLayout *l);
+  static text_layout_key_t
+  text_layout_key(const unit_memory_storage_t &memory);
+  std::size_t layout_attributes_hash(void);
+  text_layout_t *frame_layout(void);
+  void show_layout(cairo_t *cr, double x, double y);
+  void layout_path(cairo_t *cr, double x, double y);
+  void mask_layout(cairo_t *cr, double x, double y);
+  bool state_damage(display_context_t &context);
+  bool create_shadow(void);
+  text_render_function_t precise_rendering_function(void);
+
+  template <text_paint_t paint, bool bShadow, bool bOptions>
+  static void render_text(textual_render_storage_t &text, cairo_t *cr,
+                          coordinate_t &a);
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::textual_render_storage_t);
@@ -563,6 +764,350 @@ public:
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_tab_stops_storage_t);
 
+/**
+\internal
+\class group_storage_t
+\brief storage for a named group. The group owns a sub display list of
+drawing objects and the union of their ink rectangles as its bounds. The
+children are rendered once into a cached layer surface which is composited
+onto the parent surface. Changing the offset, visibility or opacity of the
+group only recomposites the layer.
+
+\details Groups may be nested. A child group is a member of the parent's
+display list, so the bounds are hierarchical.
+
+ */
+namespace uxdevice {
+class group_t;
+class group_storage_t : virtual public hash_members_t {
+public:
+  group_storage_t() {}
+
+  /// @brief copy constructor
+  group_storage_t(const group_storage_t &other)
+      : group_display_list(other.group_display_list), bounds(other.bounds),
+        offset_x(other.offset_x), offset_y(other.offset_y),
+        alpha(other.alpha), visible(other.visible),
+        layer_hash(other.layer_hash), parent(other.parent),
+        context(other.context) {}
+
+  /// @brief move constructor
+  group_storage_t(group_storage_t &&other) noexcept
+      : group_display_list(std::move(other.group_display_list)),
+        bounds(other.bounds), offset_x(other.offset_x),
+        offset_y(other.offset_y), alpha(other.alpha), visible(other.visible),
+        layer_hash(other.layer_hash), parent(other.parent),
+        context(other.context) {}
+
+  /// @brief copy assignment operator
+  group_storage_t &operator=(const group_storage_t &other) {
+    group_display_list = other.group_display_list;
+    bounds = other.bounds;
+    offset_x = other.offset_x;
+    offset_y = other.offset_y;
+    alpha = other.alpha;
+    visible = other.visible;
+    layer_hash = other.layer_hash;
+    parent = other.parent;
+    context = other.context;
+    return *this;
+  }
+
+  /// @brief move assignment
+  group_storage_t &operator=(group_storage_t &&other) noexcept {
+    group_display_list = std::move(other.group_display_list);
+    bounds = other.bounds;
+    offset_x = other.offset_x;
+    offset_y = other.offset_y;
+    alpha = other.alpha;
+    visible = other.visible;
+    layer_hash = other.layer_hash;
+    parent = other.parent;
+    context = other.context;
+    return *this;
+  }
+
+  virtual ~group_storage_t() {}
+
+  mutable std::atomic_flag lockGroup = ATOMIC_FLAG_INIT;
+#define GROUP_SPIN while (lockGroup.test_and_set(std::memory_order_acquire))
+#define GROUP_CLEAR lockGroup.clear(std::memory_order_release)
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, std::type_index(typeid(group_storage_t)), offset_x,
+                 offset_y, alpha, visible, group_hash_code());
+    return __value;
+  }
+
+  /// @brief hash of the children only. When this changes the cached layer
+  /// must be rendered again.
+  std::size_t group_hash_code(void) const noexcept {
+    std::size_t __value = {};
+    GROUP_SPIN;
+    for (auto &n : group_display_list)
+      hash_combine(__value, n->hash_code());
+    hash_combine(__value, group_display_list.size());
+    GROUP_CLEAR;
+    return __value;
+  }
+
+  drawing_output_collection_t group_display_list = {};
+  cairo_rectangle_int_t bounds = cairo_rectangle_int_t();
+  double offset_x = {};
+  double offset_y = {};
+  double alpha = 1.0;
+  bool visible = true;
+  std::size_t layer_hash = {};
+  group_t *parent = nullptr;
+  display_context_t *context = nullptr;
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::group_storage_t);
+
+/**
+\internal
+\class recorded_path_storage_t
+\brief storage for a path captured while the surface is recording. The cairo
+path and attribute units are held as a list of calls which are replayed on
+the render thread. The painting unit that completed the path, stroke, fill or
+paint, is held separately so the extents of the path can be computed before
+it is consumed.
+
+\details recorded_hash is the combined hash of the recorded units. It stands
+for the list of calls since the function objects cannot be hashed by value.
+
+ */
+namespace uxdevice {
+class recorded_path_storage_t : virtual public hash_members_t {
+public:
+  typedef std::function<bool(cairo_t *cr, cairo_rectangle_t &r)>
+      path_extents_function_t;
+
+  recorded_path_storage_t() {}
+
+  /// @brief copy constructor
+  recorded_path_storage_t(const recorded_path_storage_t &other)
+      : attributes(other.attributes), commands(other.commands),
+        paint(other.paint), extents(other.extents),
+        recorded_hash(other.recorded_hash) {}
+
+  /// @brief move constructor
+  recorded_path_storage_t(recorded_path_storage_t &&other) noexcept
+      : attributes(std::move(other.attributes)),
+        commands(std::move(other.commands)), paint(std::move(other.paint)),
+        extents(std::move(other.extents)), recorded_hash(other.recorded_hash) {
+  }
+
+  /// @brief copy assignment operator
+  recorded_path_storage_t &operator=(const recorded_path_storage_t &other) {
+    attributes = other.attributes;
+    commands = other.commands;
+    paint = other.paint;
+    extents = other.extents;
+    recorded_hash = other.recorded_hash;
+    return *this;
+  }
+
+  /// @brief move assignment
+  recorded_path_storage_t &operator=(recorded_path_storage_t &&other) noexcept {
+    attributes = std::move(other.attributes);
+    commands = std::move(other.commands);
+    paint = std::move(other.paint);
+    extents = std::move(other.extents);
+    recorded_hash = other.recorded_hash;
+    return *this;
+  }
+
+  virtual ~recorded_path_storage_t() {}
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, std::type_index(typeid(recorded_path_storage_t)),
+                 recorded_hash, attributes.size(), commands.size());
+    return __value;
+  }
+
+  /// @brief replays the attributes and path. The paint call is not made.
+  void replay(cairo_t *cr) {
+    for (auto &fn : attributes)
+      fn(cr);
+    for (auto &fn : commands)
+      fn(cr);
+  }
+
+  std::list<cairo_function_t> attributes = {};
+  std::list<cairo_function_t> commands = {};
+  cairo_function_t paint = {};
+  path_extents_function_t extents = {};
+  std::size_t recorded_hash = {};
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::recorded_path_storage_t);
+
+/**
+\internal
+\class text_view_storage_t
+\brief storage for a text view. The text is held by a shared line index over
+a mapped file or a buffer owned by the caller. The window holds the shaped
+layouts of the lines in view plus a margin above and below. Lines have a
+fixed height so the position of any line is computed directly.
+
+\details copies share the line index.
+
+ */
+namespace uxdevice {
+class text_view_storage_t : virtual public hash_members_t,
+                            public unit_memory_storage_t {
+public:
+  text_view_storage_t() {}
+  text_view_storage_t(const std::string &file_name)
+      : line_index(std::make_shared<text_line_index_t>(file_name)) {}
+  text_view_storage_t(const char *data, std::size_t size)
+      : line_index(std::make_shared<text_line_index_t>(data, size)) {}
+
+  /// @brief copy constructor
+  text_view_storage_t(const text_view_storage_t &other)
+      : unit_memory_storage_t(other), line_index(other.line_index),
+        top_line(other.top_line.load()), window(other.window),
+        window_line(other.window_line), line_height(other.line_height) {}
+
+  /// @brief move constructor
+  text_view_storage_t(text_view_storage_t &&other) noexcept
+      : unit_memory_storage_t(other), line_index(std::move(other.line_index)),
+        top_line(other.top_line.load()), window(std::move(other.window)),
+        window_line(other.window_line), line_height(other.line_height) {}
+
+  /// @brief copy assignment operator
+  text_view_storage_t &operator=(const text_view_storage_t &other) {
+    unit_memory_storage_t::operator=(other);
+    line_index = other.line_index;
+    top_line = other.top_line.load();
+    window = other.window;
+    window_line = other.window_line;
+    line_height = other.line_height;
+    return *this;
+  }
+
+  /// @brief move assignment
+  text_view_storage_t &operator=(text_view_storage_t &&other) noexcept {
+    unit_memory_storage_t::operator=(other);
+    line_index = std::move(other.line_index);
+    top_line = other.top_line.load();
+    window = std::move(other.window);
+    window_line = other.window_line;
+    line_height = other.line_height;
+    return *this;
+  }
+
+  virtual ~text_view_storage_t() {}
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, std::type_index(typeid(text_view_storage_t)),
+                 line_index.get(), top_line.load(),
+                 unit_memory<text_color_t>(), unit_memory<text_font_t>(),
+                 unit_memory<coordinate_t>());
+    return __value;
+  }
+
+  std::shared_ptr<text_line_index_t> line_index = {};
+  std::atomic<std::size_t> top_line = {};
+  std::vector<text_layout_cache_t::text_layout_ptr_t> window = {};
+  std::size_t window_line = {};
+  int line_height = {};
+
+  static constexpr std::size_t margin_lines = 8;
+  static constexpr std::size_t line_limit = 4096;
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_view_storage_t);
+
+/**
+\internal
+\class text_console_storage_t
+\brief storage for a text console. The lines are held by a shared console
+buffer. The surface holds the lines drawn so far, with the line numbered
+surface_line at its top. The layout is created upon the surface and reused
+for each line.
+
+\details copies share the console buffer. The surface is private to each
+object and is created when first drawn.
+
+ */
+namespace uxdevice {
+class text_console_storage_t : virtual public hash_members_t,
+                               public unit_memory_storage_t {
+public:
+  text_console_storage_t() {}
+  text_console_storage_t(std::size_t capacity)
+      : buffer(std::make_shared<text_console_buffer_t>(capacity)) {}
+
+  /// @brief copy constructor
+  text_console_storage_t(const text_console_storage_t &other)
+      : unit_memory_storage_t(other), buffer(other.buffer),
+        context(other.context.load()) {}
+
+  /// @brief move constructor
+  text_console_storage_t(text_console_storage_t &&other) noexcept
+      : unit_memory_storage_t(other), buffer(std::move(other.buffer)),
+        context(other.context.load()) {}
+
+  /// @brief copy assignment operator
+  text_console_storage_t &operator=(const text_console_storage_t &other) {
+    unit_memory_storage_t::operator=(other);
+    buffer = other.buffer;
+    context = other.context.load();
+    release_surface();
+    return *this;
+  }
+
+  /// @brief move assignment
+  text_console_storage_t &operator=(text_console_storage_t &&other) noexcept {
+    unit_memory_storage_t::operator=(other);
+    buffer = std::move(other.buffer);
+    context = other.context.load();
+    release_surface();
+    return *this;
+  }
+
+  virtual ~text_console_storage_t() { release_surface(); }
+
+  void release_surface(void) {
+    if (layout)
+      g_object_unref(layout);
+    if (cr)
+      cairo_destroy(cr);
+    if (surface)
+      cairo_surface_destroy(surface);
+    layout = nullptr;
+    cr = nullptr;
+    surface = nullptr;
+  }
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, std::type_index(typeid(text_console_storage_t)),
+                 buffer.get(), unit_memory<text_color_t>(),
+                 unit_memory<text_font_t>(), unit_memory<coordinate_t>());
+    return __value;
+  }
+
+  std::shared_ptr<text_console_buffer_t> buffer = {};
+  std::atomic<display_context_t *> context = nullptr;
+
+  cairo_surface_t *surface = nullptr;
+  cairo_t *cr = nullptr;
+  PangoLayout *layout = nullptr;
+  std::size_t surface_line = {};
+  std::size_t surface_hash = {};
+  int line_height = {};
+
+  static constexpr std::size_t line_limit = 4096;
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_console_storage_t);
+
 /********************************************************************************
 
                       API objects
@@ -675,6 +1220,25 @@ public:
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_render_path_t);
 
+/**
+\class text_render_atlas_t
+\brief selects glyph atlas rendering. Glyphs are rasterized once into a
+shared atlas and the text is painted with the text_color_t brush through a
+coverage mask composed from the atlas.
+*/
+namespace uxdevice {
+using text_render_atlas_t = class text_render_atlas_t
+    : public marker_emitter_t<text_render_atlas_t,
+                              attribute_display_context_memory_t,
+                              emit_display_context_abstract_t> {
+public:
+  using marker_emitter_t::marker_emitter_t;
+
+  void emit(display_context_t &context);
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_render_atlas_t);
+
 /**
 \class
 \brief
@@ -835,6 +1399,9 @@ public:
   using storage_emitter_t::storage_emitter_t;
   std::size_t hash_code(void) const noexcept;
   void emit(PangoLayout *layout);
+
+  bool is_editable(void) const noexcept;
+  std::string_view view(std::string &buffer) const;
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_data_t);
@@ -1112,6 +1679,153 @@ public:
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::image_block_t);
 
+/**
+\class image_view_t
+\brief displays an image too large to decode whole, such as a map or a
+scan, from a png file, base 64 png data or an svg. The image is read in
+tiles on the image decode threads. Only the tiles within the coordinate at
+the current zoom, plus a ring around them, are kept once the tiles exceed
+their memory budget. The view is moved with scroll() and zoom(). The
+coordinate_t within the context memory is used.
+*/
+namespace uxdevice {
+using image_view_t = class image_view_t
+    : public class_storage_drawing_function_t<image_view_t,
+                                              image_view_storage_t,
+                                              emit_display_context_abstract_t> {
+public:
+  using class_storage_drawing_function_t::class_storage_drawing_function_t;
+
+  void emit(display_context_t &context);
+
+  image_view_t &scroll(double x, double y);
+  image_view_t &zoom(double z);
+  std::array<int, 2> image_size(void);
+
+private:
+  void render(display_context_t &context, const coordinate_t &a,
+              const cairo_rectangle_t &area);
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::image_view_t);
+
+/**
+\class group_t
+\brief a named group of drawing objects rendered into a cached layer. The
+group is created and selected with surface_area_t::group_begin(name) and
+closed with surface_area_t::group_end(). Drawing objects inserted while a group is
+open become members of the group's display list. The move, hide, show and
+opacity members recomposite the cached layer without rendering the children.
+*/
+namespace uxdevice {
+using group_t = class group_t
+    : public class_storage_drawing_function_t<group_t, group_storage_t,
+                                              emit_display_context_abstract_t> {
+public:
+  using class_storage_drawing_function_t::class_storage_drawing_function_t;
+
+  void emit(display_context_t &context);
+
+  void add_drawable(std::shared_ptr<drawing_output_t> _obj);
+  void update_bounds(void);
+  void damage(void);
+
+  group_t &move(double x, double y);
+  group_t &opacity(double a);
+  group_t &hide(void);
+  group_t &show(void);
+
+private:
+  void render_layer(display_context_t &context);
+  void composite(display_context_t &context, bool bclipped);
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::group_t);
+
+/**
+\class recorded_path_t
+\brief a path and its painting operation captured while the surface is
+recording. See surface_area_t::recording(bool). The object is created by the
+surface and completed when a stroke, fill or paint unit is inserted. The
+extents are computed at that time on a private cairo context, so the object
+may be culled and cached as any other drawing object. All calls to the
+surface cairo context occur on the render thread.
+*/
+namespace uxdevice {
+using recorded_path_t = class recorded_path_t
+    : public class_storage_drawing_function_t<recorded_path_t,
+                                              recorded_path_storage_t,
+                                              emit_display_context_abstract_t> {
+public:
+  using class_storage_drawing_function_t::class_storage_drawing_function_t;
+
+  void emit(display_context_t &context);
+
+private:
+  void replay(display_context_t &context, bool bclipped);
+  void render_cache(display_context_t &context);
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::recorded_path_t);
+
+/**
+\class text_view_t
+\brief displays a large text from a file or from a buffer owned by the
+caller without copying it. The file is mapped and its lines are indexed by a
+background scan. Only the lines within the coordinate, plus a small margin,
+are shaped and drawn. The text_font_t, text_color_t and coordinate_t within
+the context memory are used. Lines are not wrapped. Scrolling to any line
+takes the same time regardless of the size of the text.
+*/
+namespace uxdevice {
+using text_view_t = class text_view_t
+    : public class_storage_drawing_function_t<text_view_t, text_view_storage_t,
+                                              emit_display_context_abstract_t> {
+public:
+  using class_storage_drawing_function_t::class_storage_drawing_function_t;
+
+  void emit(display_context_t &context);
+
+  text_view_t &scroll(std::size_t line);
+  std::size_t line_count(void);
+
+private:
+  void layout_window(const coordinate_t &a);
+  void render(cairo_t *cr, coordinate_t &a);
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_view_t);
+
+/**
+\class text_console_t
+\brief displays lines appended from any thread, in the manner of a terminal
+following a log. The most recent lines that fit within the coordinate are
+shown and the view scrolls as lines arrive. The number of lines retained is
+given when the object is created. Only lines not yet drawn are shaped. The
+lines already drawn are moved up within a private surface. The text_font_t,
+text_color_t and coordinate_t within the context memory are used. Lines are
+not wrapped.
+*/
+namespace uxdevice {
+using text_console_t = class text_console_t
+    : public class_storage_drawing_function_t<text_console_t,
+                                              text_console_storage_t,
+                                              emit_display_context_abstract_t> {
+public:
+  using class_storage_drawing_function_t::class_storage_drawing_function_t;
+
+  void emit(display_context_t &context);
+
+  text_console_t &append(const std::string_view &text);
+  std::size_t line_count(void);
+
+private:
+  void update_surface(coordinate_t &a);
+  void render(cairo_t *cr, coordinate_t &a);
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_console_t);
+
 /**
 \class
 \brief
@@ -1236,11 +1950,13 @@ UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::rectangle_t);
 namespace uxdevice {
 using stroke_path_t = class stroke_path_t
     : public class_storage_drawing_function_t<stroke_path_t, painter_brush_t,
-                                              emit_cairo_abstract_t> {
+                                              emit_cairo_abstract_t,
+                                              path_paint_abstract_t> {
 public:
   using class_storage_drawing_function_t::class_storage_drawing_function_t;
 
   void emit(cairo_t *cr);
+  bool path_extents(cairo_t *cr, cairo_rectangle_t &r);
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::stroke_path_t);
@@ -1252,11 +1968,13 @@ UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::stroke_path_t);
 namespace uxdevice {
 using fill_path_t = class fill_path_t
     : public class_storage_drawing_function_t<fill_path_t, painter_brush_t,
-                                              emit_cairo_abstract_t> {
+                                              emit_cairo_abstract_t,
+                                              path_paint_abstract_t> {
 public:
   using class_storage_drawing_function_t::class_storage_drawing_function_t;
 
   void emit(cairo_t *cr);
+  bool path_extents(cairo_t *cr, cairo_rectangle_t &r);
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::fill_path_t);
@@ -1269,11 +1987,13 @@ namespace uxdevice {
 using stroke_fill_path_t = class stroke_fill_path_t
     : public class_storage_drawing_function_t<stroke_fill_path_t,
                                               stroke_fill_path_storage_t,
-                                              emit_cairo_abstract_t> {
+                                              emit_cairo_abstract_t,
+                                              path_paint_abstract_t> {
 public:
   using class_storage_drawing_function_t::class_storage_drawing_function_t;
 
   void emit(cairo_t *cr);
+  bool path_extents(cairo_t *cr, cairo_rectangle_t &r);
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::stroke_fill_path_t);
@@ -1285,11 +2005,13 @@ UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::stroke_fill_path_t);
 namespace uxdevice {
 using mask_t = class mask_t
     : public class_storage_drawing_function_t<mask_t, painter_brush_t,
-                                              emit_cairo_abstract_t> {
+                                              emit_cairo_abstract_t,
+                                              path_paint_abstract_t> {
 public:
   using class_storage_drawing_function_t::class_storage_drawing_function_t;
 
   void emit(cairo_t *cr);
+  bool path_extents(cairo_t *cr, cairo_rectangle_t &r);
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::mask_t);
@@ -1301,11 +2023,13 @@ UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::mask_t);
 namespace uxdevice {
 using paint_t =
     class paint_t : public storage_drawing_function_t<paint_t, double,
-                                                      emit_cairo_abstract_t> {
+                                                      emit_cairo_abstract_t,
+                                                      path_paint_abstract_t> {
 public:
   using storage_drawing_function_t::storage_drawing_function_t;
 
   void emit(cairo_t *cr);
+  bool path_extents(cairo_t *cr, cairo_rectangle_t &r);
 };
 } // namespace uxdevice
 UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::paint_t);
@@ -125,4 +125,9 @@ enum class content_options_t {
   alpha = CAIRO_CONTENT_ALPHA,
   all = CAIRO_CONTENT_COLOR_ALPHA
 };
+
+/// @brief the blur of shadows. automatic selects by radius and surface size
+/// under the blur quality. scaled blurs a reduced copy of the surface.
+enum class blur_engine_t { automatic, stack, box, scaled };
+enum class blur_quality_t { fast, good, best };
 } // namespace uxdevice
@@ -118,7 +118,13 @@ bool uxdevice::painter_brush_t::create(void) {
     double _width = {};
     double _height = {};
 
-    auto _image = read_image(data_storage->description, _width, _height);
+    // images are shared through the image cache. The pattern holds its own
+    // reference to the surface.
+    auto decoded =
+        image_cache_t::read(data_storage->description, _width, _height);
+    cairo_surface_t *_image = nullptr;
+    if (decoded->image)
+      _image = cairo_surface_reference(decoded->image);
 
     if (_image) {
 
@@ -0,0 +1,1107 @@
+/*
+ * This file is part of the PLATFORM_OBJ distribution
+ * {https://github.com/amatarazzo777/platform_obj). Copyright (c) 2020 Anthony
+ * Matarazzo.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+\author Anthony Matarazzo
+\file uxtextlayout.cpp
+\date 10/18/20
+\version 1.0
+\brief Shared text layout services.
+
+*/
+
+#include "uxdevice.hpp"
+
+namespace {
+typedef std::unordered_map<uxdevice::text_layout_key_t,
+                           uxdevice::text_layout_cache_t::text_layout_future_t>
+    text_layout_map_t;
+
+text_layout_map_t &text_layout_map(void) {
+  static text_layout_map_t layouts = {};
+  return layouts;
+}
+
+// the map is locked only while it is searched or changed. shaping occurs
+// outside of the lock.
+std::mutex &text_layout_mutex(void) {
+  static std::mutex m = {};
+  return m;
+}
+
+// the size at which the map is next trimmed. Called with the map locked.
+std::size_t &text_layout_trim_size(void) {
+  static std::size_t size = uxdevice::text_layout_cache_t::limit;
+  return size;
+}
+
+uxdevice::background_work_t &text_shaping_work(void) {
+  static uxdevice::background_work_t work(std::thread::hardware_concurrency());
+  return work;
+}
+
+/// @brief releases the pango contexts of a thread when the thread exits.
+/// The interactive context shapes with gray font antialiasing. Both use the
+/// default font map of the thread, which is locked while it is used.
+class thread_pango_context_t {
+public:
+  thread_pango_context_t()
+      : context(
+            pango_font_map_create_context(pango_cairo_font_map_get_default())),
+        interactive(
+            pango_font_map_create_context(pango_cairo_font_map_get_default())) {
+    cairo_font_options_t *options = cairo_font_options_create();
+    cairo_font_options_set_antialias(options, CAIRO_ANTIALIAS_GRAY);
+    pango_cairo_context_set_font_options(interactive, options);
+    cairo_font_options_destroy(options);
+  }
+  ~thread_pango_context_t() {
+    g_object_unref(context);
+    g_object_unref(interactive);
+  }
+  PangoContext *context = nullptr;
+  PangoContext *interactive = nullptr;
+  std::shared_ptr<std::mutex> font_map_lock = std::make_shared<std::mutex>();
+};
+
+/// @brief the pango contexts of the calling thread. The default cairo font
+/// map is private to each thread, so threads shape text in parallel.
+thread_pango_context_t &thread_pango_context(void) {
+  static thread_local thread_pango_context_t thread_context = {};
+  return thread_context;
+}
+} // namespace
+
+/**
+\internal
+\fn text_layout_cache_t::shape
+\brief creates, sets up and measures a new layout on the calling thread with
+the font map of the thread locked.
+*/
+uxdevice::text_layout_cache_t::text_layout_ptr_t
+uxdevice::text_layout_cache_t::shape(bool interactive,
+                                     const layout_setup_t &fn_setup) {
+  thread_pango_context_t &thread_context = thread_pango_context();
+  std::lock_guard<std::mutex> guard(*thread_context.font_map_lock);
+  PangoLayout *layout = pango_layout_new(
+      interactive ? thread_context.interactive : thread_context.context);
+  fn_setup(layout);
+  return std::make_shared<text_layout_t>(layout, thread_context.font_map_lock);
+}
+
+/**
+\internal
+\fn text_layout_cache_t::find_or_insert
+\brief returns the entry of the key. When the key is not present, an entry
+is added which becomes ready when the promise is fulfilled, and true is
+returned. The caller must then shape the layout.
+*/
+bool uxdevice::text_layout_cache_t::find_or_insert(
+    const text_layout_key_t &key, std::promise<text_layout_ptr_t> &promise,
+    text_layout_future_t &future) {
+  std::lock_guard<std::mutex> lock(text_layout_mutex());
+  auto &layouts = text_layout_map();
+
+  auto n = layouts.find(key);
+  if (n != layouts.end()) {
+    future = n->second;
+    return false;
+  }
+
+  if (layouts.size() >= text_layout_trim_size())
+    trim();
+
+  future = promise.get_future().share();
+  layouts[key] = future;
+  return true;
+}
+
+/**
+\internal
+\fn text_layout_cache_t::acquire
+\param const text_layout_key_t &key - the shaping parameters.
+\param const layout_setup_t &fn_setup - applies the parameters to a new
+layout. Only called when the layout is not within the cache.
+
+\brief returns the shaped layout for the key. A new layout is shaped on the
+calling thread. When another thread is shaping the same key, the layout it
+produces is waited for.
+*/
+uxdevice::text_layout_cache_t::text_layout_ptr_t
+uxdevice::text_layout_cache_t::acquire(const text_layout_key_t &key,
+                                       const layout_setup_t &fn_setup) {
+  std::promise<text_layout_ptr_t> promise = {};
+  text_layout_future_t future = {};
+  if (find_or_insert(key, promise, future))
+    promise.set_value(shape(key.interactive, fn_setup));
+
+  return future.get();
+}
+
+/**
+\internal
+\fn text_layout_cache_t::acquire_async
+\param const text_layout_key_t &key - the shaping parameters.
+\param const layout_setup_t &fn_setup - applies the parameters to a new
+layout. Called on a shaping thread, so it must not refer to objects that
+may change or be released before the layout is ready.
+
+\brief returns a future of the shaped layout for the key. New layouts are
+shaped by a pool of threads, one for each core, so many texts are shaped in
+parallel.
+*/
+uxdevice::text_layout_cache_t::text_layout_future_t
+uxdevice::text_layout_cache_t::acquire_async(const text_layout_key_t &key,
+                                             const layout_setup_t &fn_setup) {
+  auto promise = std::make_shared<std::promise<text_layout_ptr_t>>();
+  text_layout_future_t future = {};
+  if (find_or_insert(key, *promise, future))
+    text_shaping_work().submit([promise, interactive = key.interactive,
+                                fn_setup]() {
+      promise->set_value(shape(interactive, fn_setup));
+    });
+
+  return future;
+}
+
+/**
+\internal
+\fn text_layout_cache_t::trim
+\brief releases shaped layouts that are only referenced by the cache until
+the cache holds three quarters of the limit. The next trim occurs once a
+quarter of the limit has been added again, so when the layouts are all in
+use the cache is not scanned for every new entry. Called with the cache
+locked.
+*/
+void uxdevice::text_layout_cache_t::trim(void) {
+  auto &layouts = text_layout_map();
+  const std::size_t low = limit - limit / 4;
+  for (auto n = layouts.begin(); n != layouts.end() && layouts.size() > low;) {
+    // the shared state of the future holds one reference.
+    if (n->second.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready &&
+        n->second.get().use_count() == 1)
+      n = layouts.erase(n);
+    else
+      n++;
+  }
+  text_layout_trim_size() = std::max(limit, layouts.size() + limit / 4);
+}
+
+/**
+\fn text_layout_cache_t::clear
+\brief releases the cache entries. Layouts in use by text objects remain
+valid until those objects release them.
+*/
+void uxdevice::text_layout_cache_t::clear(void) {
+  std::lock_guard<std::mutex> lock(text_layout_mutex());
+  text_layout_map().clear();
+  text_layout_trim_size() = limit;
+}
+
+namespace {
+class glyph_entry_t {
+public:
+  int x = {};
+  int y = {};
+  int width = {};
+  int height = {};
+  int offset_x = {};
+  int offset_y = {};
+};
+
+class glyph_atlas_storage_t {
+public:
+  cairo_surface_t *surface = nullptr;
+  cairo_t *cr = nullptr;
+  int shelf_x = {};
+  int shelf_y = {};
+  int shelf_height = {};
+  std::unordered_map<uxdevice::glyph_key_t, glyph_entry_t> entries = {};
+  std::mutex mutex = {};
+};
+
+glyph_atlas_storage_t &glyph_atlas_storage(void) {
+  static glyph_atlas_storage_t atlas = {};
+  return atlas;
+}
+
+/// @brief empties the atlas. Called with the atlas locked.
+void glyph_atlas_reset(glyph_atlas_storage_t &atlas) {
+  if (!atlas.surface) {
+    const int size = uxdevice::glyph_atlas_t::atlas_size;
+    atlas.surface = cairo_image_surface_create(CAIRO_FORMAT_A8, size, size);
+    atlas.cr = cairo_create(atlas.surface);
+  }
+  cairo_save(atlas.cr);
+  cairo_set_operator(atlas.cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint(atlas.cr);
+  cairo_restore(atlas.cr);
+  atlas.shelf_x = 0;
+  atlas.shelf_y = 0;
+  atlas.shelf_height = 0;
+  atlas.entries.clear();
+}
+
+/// @brief returns the atlas cell of the glyph, rasterizing it when it is
+/// not present. Called with the atlas locked.
+const glyph_entry_t &glyph_atlas_entry(glyph_atlas_storage_t &atlas,
+                                       const uxdevice::glyph_key_t &key,
+                                       cairo_scaled_font_t *scaled_font) {
+  auto n = atlas.entries.find(key);
+  if (n != atlas.entries.end())
+    return n->second;
+
+  const int size = uxdevice::glyph_atlas_t::atlas_size;
+  double subpixel = static_cast<double>(key.subpixel) /
+                    uxdevice::glyph_atlas_t::subpixel_positions;
+  cairo_glyph_t glyph = {key.glyph, 0, 0};
+  cairo_text_extents_t extents = {};
+  cairo_scaled_font_glyph_extents(scaled_font, &glyph, 1, &extents);
+
+  glyph_entry_t entry = {};
+  entry.offset_x =
+      static_cast<int>(std::floor(extents.x_bearing + subpixel)) - 1;
+  entry.offset_y = static_cast<int>(std::floor(extents.y_bearing)) - 1;
+  entry.width = static_cast<int>(std::ceil(extents.x_bearing + subpixel +
+                                           extents.width)) -
+                entry.offset_x + 1;
+  entry.height =
+      static_cast<int>(std::ceil(extents.y_bearing + extents.height)) -
+      entry.offset_y + 1;
+  entry.width = std::min(std::max(entry.width, 1), size);
+  entry.height = std::min(std::max(entry.height, 1), size);
+
+  // shelf packing, start a new shelf or begin again when full.
+  if (atlas.shelf_x + entry.width > size) {
+    atlas.shelf_x = 0;
+    atlas.shelf_y += atlas.shelf_height;
+    atlas.shelf_height = 0;
+  }
+  if (atlas.shelf_y + entry.height > size)
+    glyph_atlas_reset(atlas);
+
+  entry.x = atlas.shelf_x;
+  entry.y = atlas.shelf_y;
+  atlas.shelf_x += entry.width;
+  atlas.shelf_height = std::max(atlas.shelf_height, entry.height);
+
+  cairo_save(atlas.cr);
+  cairo_rectangle(atlas.cr, entry.x, entry.y, entry.width, entry.height);
+  cairo_clip(atlas.cr);
+  cairo_set_scaled_font(atlas.cr, scaled_font);
+  cairo_set_source_rgba(atlas.cr, 0, 0, 0, 1);
+  glyph.x = entry.x - entry.offset_x + subpixel;
+  glyph.y = entry.y - entry.offset_y;
+  cairo_show_glyphs(atlas.cr, &glyph, 1);
+  cairo_restore(atlas.cr);
+
+  return atlas.entries[key] = entry;
+}
+} // namespace
+
+/**
+\internal
+\fn glyph_atlas_t::layout_mask
+\param PangoLayout *layout - a shaped layout.
+\param int &origin_x - receives the mask position relative to the layout.
+\param int &origin_y
+
+\brief composes the A8 coverage of the layout from atlas cells. Each run of
+glyphs is walked. Glyphs missing from the atlas are rasterized once. The
+cells are added into the mask with saturation as neighbouring glyphs may
+overlap.
+*/
+cairo_surface_t *uxdevice::glyph_atlas_t::layout_mask(PangoLayout *layout,
+                                                      int &origin_x,
+                                                      int &origin_y) {
+  PangoRectangle ink_rect = {}, logical_rect = {};
+  pango_layout_get_pixel_extents(layout, &ink_rect, &logical_rect);
+
+  origin_x = ink_rect.x - 1;
+  origin_y = ink_rect.y - 1;
+  int mask_width = std::max(ink_rect.width + 2, 1);
+  int mask_height = std::max(ink_rect.height + 2, 1);
+
+  cairo_surface_t *mask =
+      cairo_image_surface_create(CAIRO_FORMAT_A8, mask_width, mask_height);
+  cairo_surface_flush(mask);
+  unsigned char *mask_data = cairo_image_surface_get_data(mask);
+  int mask_stride = cairo_image_surface_get_stride(mask);
+
+  auto &atlas = glyph_atlas_storage();
+  std::lock_guard<std::mutex> lock(atlas.mutex);
+  if (!atlas.surface)
+    glyph_atlas_reset(atlas);
+
+  PangoLayoutIter *iter = pango_layout_get_iter(layout);
+  do {
+    PangoLayoutRun *run = pango_layout_iter_get_run_readonly(iter);
+    if (!run)
+      continue;
+
+    PangoFont *font = run->item->analysis.font;
+    cairo_scaled_font_t *scaled_font =
+        pango_cairo_font_get_scaled_font(PANGO_CAIRO_FONT(font));
+    if (!scaled_font)
+      continue;
+
+    PangoFontDescription *description =
+        pango_font_describe_with_absolute_size(font);
+    std::size_t font_hash = pango_font_description_hash(description);
+    pango_font_description_free(description);
+
+    PangoRectangle run_rect = {};
+    pango_layout_iter_get_run_extents(iter, nullptr, &run_rect);
+    int baseline = pango_layout_iter_get_baseline(iter);
+    int x = run_rect.x;
+
+    PangoGlyphString *glyphs = run->glyphs;
+    for (int i = 0; i < glyphs->num_glyphs; i++) {
+      PangoGlyphInfo &info = glyphs->glyphs[i];
+      double gx =
+          static_cast<double>(x + info.geometry.x_offset) / PANGO_SCALE;
+      double gy =
+          static_cast<double>(baseline + info.geometry.y_offset) / PANGO_SCALE;
+      x += info.geometry.width;
+
+      if (info.glyph == PANGO_GLYPH_EMPTY ||
+          (info.glyph & PANGO_GLYPH_UNKNOWN_FLAG))
+        continue;
+
+      int ix = static_cast<int>(std::floor(gx));
+      int iy = static_cast<int>(std::floor(gy + 0.5));
+      int subpixel = static_cast<int>((gx - ix) * subpixel_positions);
+
+      const glyph_entry_t &entry = glyph_atlas_entry(
+          atlas, glyph_key_t{font_hash, info.glyph, subpixel}, scaled_font);
+
+      cairo_surface_flush(atlas.surface);
+      const unsigned char *atlas_data =
+          cairo_image_surface_get_data(atlas.surface);
+      int atlas_stride = cairo_image_surface_get_stride(atlas.surface);
+
+      // copy the cell, clipped to the mask.
+      int dx = ix + entry.offset_x - origin_x;
+      int dy = iy + entry.offset_y - origin_y;
+      for (int row = std::max(0, -dy);
+           row < entry.height && dy + row < mask_height; row++) {
+        const unsigned char *src =
+            atlas_data + (entry.y + row) * atlas_stride + entry.x;
+        unsigned char *dst = mask_data + (dy + row) * mask_stride;
+        for (int col = std::max(0, -dx);
+             col < entry.width && dx + col < mask_width; col++) {
+          unsigned int v = dst[dx + col] + src[col];
+          dst[dx + col] = static_cast<unsigned char>(std::min(v, 255u));
+        }
+      }
+    }
+  } while (pango_layout_iter_next_run(iter));
+  pango_layout_iter_free(iter);
+
+  cairo_surface_mark_dirty(mask);
+  return mask;
+}
+
+/**
+\fn glyph_atlas_t::clear
+\brief empties the glyph atlas.
+*/
+void uxdevice::glyph_atlas_t::clear(void) {
+  auto &atlas = glyph_atlas_storage();
+  std::lock_guard<std::mutex> lock(atlas.mutex);
+  if (atlas.surface)
+    glyph_atlas_reset(atlas);
+}
+
+/**
+\internal
+\fn paragraph_layout_t::paragraph_t::extents
+\brief the union of the ink and logical rectangles of the paragraph,
+relative to the layout origin.
+*/
+cairo_rectangle_int_t
+uxdevice::paragraph_layout_t::paragraph_t::extents(void) const noexcept {
+  const PangoRectangle &ink = shaped->ink_rect;
+  const PangoRectangle &logical = shaped->logical_rect;
+  int x1 = std::min(ink.x, logical.x);
+  int y1 = std::min(ink.y, logical.y);
+  int x2 = std::max(ink.x + ink.width, logical.x + logical.width);
+  int y2 = std::max(ink.y + ink.height, logical.y + logical.height);
+  return {x1, y + y1, x2 - x1, y2 - y1};
+}
+
+/**
+\internal
+\fn paragraph_layout_t::update
+\param const std::string_view &_text - the complete text.
+\param const text_layout_key_t &_key - the shaping parameters of the text.
+\param const options_setup_t &fn_options - applies the font and paragraph
+options to a new layout.
+
+\brief splits the text into paragraphs and lays them out. The edited range
+is the part of the text between the beginning and the end it shares with
+the previous text. Paragraphs ending before the range keep their layout and
+position. Paragraphs starting after it keep their layout and are moved by
+the change in length. Only the paragraphs overlapping the range are split
+from the text and obtained from the text layout cache. Returns true when
+any area was damaged.
+
+\details The height of the key limits the number of paragraphs shown. The
+paragraph layouts themselves are not limited in height. When the options
+change, every paragraph is laid out again.
+*/
+bool uxdevice::paragraph_layout_t::update(const std::string_view &_text,
+                                          const text_layout_key_t &_key,
+                                          const options_setup_t &fn_options) {
+  text_layout_key_t paragraph_key = _key;
+  paragraph_key.text_hash = {};
+  paragraph_key.text.clear();
+  paragraph_key.height = -1;
+  height_limit = _key.height > 0 ? _key.height / PANGO_SCALE : -1;
+
+  // the previous paragraphs are only reused when the options are the same.
+  bool reuse = paragraph_key == key;
+  key = paragraph_key;
+
+  std::vector<paragraph_t> previous = std::move(paragraphs);
+  paragraphs.clear();
+  paragraphs.reserve(previous.size() + 1);
+  damaged.clear();
+
+  // the paragraphs before index first and from index last on are outside of
+  // the edited range.
+  std::size_t first = {};
+  std::size_t last = previous.size();
+  if (reuse) {
+    std::size_t common = std::min(text.size(), _text.size());
+    std::size_t prefix =
+        std::mismatch(text.begin(), text.begin() + common, _text.begin())
+            .first -
+        text.begin();
+    std::size_t suffix =
+        std::mismatch(text.rbegin(), text.rbegin() + (common - prefix),
+                      _text.rbegin())
+            .first -
+        text.rbegin();
+
+    while (first < previous.size() && previous[first].end < prefix)
+      first++;
+    while (last > first && previous[last - 1].start > text.size() - suffix)
+      last--;
+  }
+
+  int y = {};
+  for (std::size_t index = 0; index < first; index++) {
+    paragraphs.emplace_back(previous[index]);
+    y += previous[index].shaped->logical_rect.height;
+  }
+
+  // the paragraphs within the edited range are replaced.
+  if (reuse)
+    for (std::size_t index = first; index < last; index++)
+      damage(previous[index].extents());
+
+  std::size_t start = previous.empty() ? 0 : previous[first].start;
+  std::size_t stop = last < previous.size()
+                         ? previous[last].start + _text.size() - text.size() - 1
+                         : _text.size();
+  for (;;) {
+    std::size_t end = std::min(_text.find('\n', start), stop);
+    std::string_view paragraph_text = _text.substr(start, end - start);
+    if (!paragraph_text.empty() && paragraph_text.back() == '\r')
+      paragraph_text.remove_suffix(1);
+
+    paragraph_t paragraph = {};
+    paragraph.text_hash = std::hash<std::string_view>{}(paragraph_text);
+    paragraph.start = start;
+    paragraph.end = end;
+
+    text_layout_key_t shaped_key = key;
+    shaped_key.text_hash = paragraph.text_hash;
+    shaped_key.text = paragraph_text;
+    paragraph.shaped =
+        text_layout_cache_t::acquire(shaped_key, [&](PangoLayout *l) {
+          fn_options(l);
+          pango_layout_set_width(l, key.width > 0 ? key.width : -1);
+          pango_layout_set_text(l, paragraph_text.data(),
+                                static_cast<int>(paragraph_text.size()));
+        });
+    paragraph.y = y;
+    y += paragraph.shaped->logical_rect.height;
+    damage(paragraph.extents());
+
+    paragraphs.emplace_back(std::move(paragraph));
+    if (end == stop)
+      break;
+    start = end + 1;
+  }
+
+  // the paragraphs after the edited range are moved.
+  for (std::size_t index = last; index < previous.size(); index++) {
+    paragraph_t paragraph = previous[index];
+    paragraph.start = paragraph.start + _text.size() - text.size();
+    paragraph.end = paragraph.end + _text.size() - text.size();
+    if (paragraph.y != y) {
+      damage(previous[index].extents());
+      paragraph.y = y;
+      damage(paragraph.extents());
+    }
+    y += paragraph.shaped->logical_rect.height;
+    paragraphs.emplace_back(std::move(paragraph));
+  }
+
+  bool has_ink = false;
+  int ink_x1 = {}, ink_y1 = {}, ink_x2 = {}, ink_y2 = {};
+  int logical_width = {};
+  for (auto &paragraph : paragraphs) {
+    const PangoRectangle &ink = paragraph.shaped->ink_rect;
+    if (ink.width > 0 && ink.height > 0) {
+      if (!has_ink) {
+        has_ink = true;
+        ink_x1 = ink.x;
+        ink_y1 = paragraph.y + ink.y;
+        ink_x2 = ink.x + ink.width;
+        ink_y2 = paragraph.y + ink.y + ink.height;
+      } else {
+        ink_x1 = std::min(ink_x1, ink.x);
+        ink_y1 = std::min(ink_y1, paragraph.y + ink.y);
+        ink_x2 = std::max(ink_x2, ink.x + ink.width);
+        ink_y2 = std::max(ink_y2, paragraph.y + ink.y + ink.height);
+      }
+    }
+    logical_width = std::max(logical_width,
+                             paragraph.shaped->logical_rect.x +
+                                 paragraph.shaped->logical_rect.width);
+  }
+
+  // when the options changed, the previous area is repainted entirely.
+  if (!reuse && !previous.empty()) {
+    int previous_height =
+        previous.back().y + previous.back().shaped->logical_rect.height;
+    int x1 = std::min(ink_rect.x, 0);
+    int y1 = std::min(ink_rect.y, 0);
+    int x2 = std::max(ink_rect.x + ink_rect.width, logical_rect.width);
+    int y2 = std::max(ink_rect.y + ink_rect.height, previous_height);
+    damage({x1, y1, x2 - x1, y2 - y1});
+  }
+
+  ink_rect = {ink_x1, ink_y1, ink_x2 - ink_x1, ink_y2 - ink_y1};
+  logical_rect = {0, 0, logical_width, y};
+  text = _text;
+
+  return !damaged.empty();
+}
+
+/**
+\internal
+\fn paragraph_layout_t::damage
+\brief notes a damaged area. Areas that touch vertically are joined, so
+paragraphs moved by an insertion form one area.
+*/
+void uxdevice::paragraph_layout_t::damage(const cairo_rectangle_int_t &r) {
+  if (r.width <= 0 || r.height <= 0)
+    return;
+
+  if (!damaged.empty()) {
+    cairo_rectangle_int_t &last = damaged.back();
+    if (r.y <= last.y + last.height && last.y <= r.y + r.height) {
+      int x1 = std::min(last.x, r.x);
+      int y1 = std::min(last.y, r.y);
+      int x2 = std::max(last.x + last.width, r.x + r.width);
+      int y2 = std::max(last.y + last.height, r.y + r.height);
+      last = {x1, y1, x2 - x1, y2 - y1};
+      return;
+    }
+  }
+  damaged.emplace_back(r);
+}
+
+/**
+\internal
+\fn paragraph_layout_t::visible
+\brief the range of paragraphs within the clip of the cairo context and the
+height limit. The first paragraph is found by a binary search of the
+positions. One paragraph before is included for ink that extends below its
+logical rectangle.
+*/
+std::pair<std::size_t, std::size_t>
+uxdevice::paragraph_layout_t::visible(cairo_t *cr, double y) {
+  double x1 = {}, y1 = {}, x2 = {}, y2 = {};
+  cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+  double top = y1 - y;
+  double bottom = y2 - y;
+  if (height_limit >= 0)
+    bottom = std::min(bottom, static_cast<double>(height_limit));
+
+  auto n = std::upper_bound(paragraphs.begin(), paragraphs.end(), top,
+                            [](double v, const paragraph_t &p) {
+                              return v < p.y + p.shaped->logical_rect.height;
+                            });
+  if (n != paragraphs.begin())
+    n--;
+
+  std::size_t first = static_cast<std::size_t>(n - paragraphs.begin());
+  std::size_t last = first;
+  while (last < paragraphs.size() && paragraphs[last].y < bottom)
+    last++;
+
+  return {first, last};
+}
+
+/**
+\internal
+\fn paragraph_layout_t::show
+\brief draws the visible paragraphs with the top left corner at x, y.
+*/
+void uxdevice::paragraph_layout_t::show(cairo_t *cr, double x, double y) {
+  auto range = visible(cr, y);
+  for (std::size_t i = range.first; i < range.second; i++) {
+    cairo_move_to(cr, x, y + paragraphs[i].y);
+    paragraphs[i].shaped->show(cr);
+  }
+}
+
+/**
+\internal
+\fn paragraph_layout_t::path
+\brief adds the outline of the visible paragraphs to the current path.
+*/
+void uxdevice::paragraph_layout_t::path(cairo_t *cr, double x, double y) {
+  auto range = visible(cr, y);
+  for (std::size_t i = range.first; i < range.second; i++) {
+    cairo_move_to(cr, x, y + paragraphs[i].y);
+    paragraphs[i].shaped->path(cr);
+  }
+}
+
+/**
+\internal
+\fn paragraph_layout_t::mask
+\brief paints the source through the glyph atlas masks of the visible
+paragraphs.
+*/
+void uxdevice::paragraph_layout_t::mask(cairo_t *cr, double x, double y) {
+  auto range = visible(cr, y);
+  for (std::size_t i = range.first; i < range.second; i++) {
+    text_layout_t &shaped = *paragraphs[i].shaped;
+    cairo_surface_t *glyph_mask = shaped.glyph_mask();
+    cairo_mask_surface(cr, glyph_mask, x + shaped.mask_x,
+                       y + paragraphs[i].y + shaped.mask_y);
+  }
+}
+
+/**
+\internal
+\fn text_line_index_t::text_line_index_t
+\param const std::string &file_name - the file to map.
+\brief maps the file. is_valid() returns false when the file could not be
+mapped.
+*/
+uxdevice::text_line_index_t::text_line_index_t(const std::string &file_name)
+    : file(std::make_unique<mapped_file_t>(file_name)) {
+  if (file->is_valid()) {
+    data = file->data();
+    size = file->size();
+  }
+}
+
+/**
+\internal
+\fn text_line_index_t::text_line_index_t
+\param const char *_data - text owned by the caller. It must remain valid
+for the life of the index.
+\param std::size_t _size - the number of bytes.
+*/
+uxdevice::text_line_index_t::text_line_index_t(const char *_data,
+                                               std::size_t _size)
+    : data(_data), size(_size) {}
+
+/**
+\internal
+\fn text_line_index_t::~text_line_index_t
+\brief stops the scan before the text is released.
+*/
+uxdevice::text_line_index_t::~text_line_index_t() {
+  cancel = true;
+  if (scan_thread.joinable())
+    scan_thread.join();
+}
+
+/**
+\internal
+\fn text_line_index_t::scan
+\param const indexed_function_t &fn_indexed - called from the scanning
+thread each time a batch of lines is published and when the scan completes.
+\brief starts the background scan. Only the first call has an effect.
+*/
+void uxdevice::text_line_index_t::scan(const indexed_function_t &fn_indexed) {
+  std::lock_guard<std::mutex> lock(offsets_mutex);
+  if (!data || scan_thread.joinable() || complete)
+    return;
+
+  offsets.push_back(0);
+  scan_thread = std::thread(&text_line_index_t::scan_lines, this, fn_indexed);
+}
+
+/**
+\internal
+\fn text_line_index_t::scan_lines
+\brief finds the new lines of the text. Offsets are collected locally and
+published under the lock once per batch.
+*/
+void uxdevice::text_line_index_t::scan_lines(indexed_function_t fn_indexed) {
+  std::vector<std::size_t> batch = {};
+  batch.reserve(batch_lines);
+
+  auto publish = [&]() {
+    std::size_t lines = {};
+    {
+      std::lock_guard<std::mutex> lock(offsets_mutex);
+      offsets.insert(offsets.end(), batch.begin(), batch.end());
+      lines = offsets.size() - 1;
+    }
+    batch.clear();
+    if (fn_indexed)
+      fn_indexed(lines);
+  };
+
+  const char *p = data;
+  const char *end = data + size;
+  while (p < end && !cancel) {
+    const char *n = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!n)
+      break;
+    p = n + 1;
+    batch.push_back(static_cast<std::size_t>(p - data));
+    if (batch.size() == batch_lines)
+      publish();
+  }
+  if (cancel)
+    return;
+
+  // the last line has no new line.
+  if (p < end)
+    batch.push_back(size + 1);
+
+  complete = true;
+  publish();
+}
+
+/**
+\internal
+\fn text_line_index_t::line_count
+\brief the number of lines indexed so far.
+*/
+std::size_t uxdevice::text_line_index_t::line_count(void) const {
+  std::lock_guard<std::mutex> lock(offsets_mutex);
+  return offsets.empty() ? 0 : offsets.size() - 1;
+}
+
+/**
+\internal
+\fn text_line_index_t::line
+\param std::size_t n - the line number.
+\brief the text of the line without its line ending. An empty view is
+returned for lines not yet indexed.
+*/
+std::string_view uxdevice::text_line_index_t::line(std::size_t n) const {
+  std::size_t start = {}, end = {};
+  {
+    std::lock_guard<std::mutex> lock(offsets_mutex);
+    if (n + 1 >= offsets.size())
+      return {};
+    start = offsets[n];
+    end = offsets[n + 1] - 1;
+  }
+
+  if (end > start && data[end - 1] == '\r')
+    end--;
+
+  return std::string_view(data + start, end - start);
+}
+
+/**
+\internal
+\fn text_console_buffer_t::~text_console_buffer_t
+\brief releases lines that were appended but never taken.
+*/
+uxdevice::text_console_buffer_t::~text_console_buffer_t() {
+  line_node_t *node = pending.exchange(nullptr);
+  while (node) {
+    line_node_t *next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+/**
+\internal
+\fn text_console_buffer_t::append
+\brief adds the text as one line per new line character. A final new line
+does not begin an empty line. May be called from any thread. Returns true
+for the first append since the render thread last took the lines, which is
+when a repaint should be requested.
+*/
+bool uxdevice::text_console_buffer_t::append(const std::string_view &text) {
+  std::size_t start = {};
+  do {
+    std::size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::size_t length = end - start;
+    if (length > 0 && text[start + length - 1] == '\r')
+      length--;
+
+    line_node_t *node = new line_node_t{std::string(text.substr(start, length)),
+                                        pending.load(std::memory_order_relaxed)};
+    while (!pending.compare_exchange_weak(node->next, node,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+      ;
+    start = end + 1;
+  } while (start < text.size());
+
+  return !signaled.exchange(true);
+}
+
+/**
+\internal
+\fn text_console_buffer_t::take
+\brief moves the appended lines into the ring in the order they were
+appended. Called by the render thread. Returns the number of new lines, which
+may exceed the capacity of the ring.
+*/
+std::size_t uxdevice::text_console_buffer_t::take(void) {
+  // the signal is cleared before the list is taken so that an append which
+  // is not part of this list always requests another repaint.
+  signaled = false;
+  line_node_t *node = pending.exchange(nullptr, std::memory_order_acquire);
+
+  // the list is newest first.
+  line_node_t *ordered = nullptr;
+  std::size_t count = {};
+  while (node) {
+    line_node_t *next = node->next;
+    node->next = ordered;
+    ordered = node;
+    node = next;
+    count++;
+  }
+
+  // only the last capacity lines are kept.
+  std::size_t first = count > capacity ? count - capacity : 0;
+  for (std::size_t i = 0; ordered; i++) {
+    line_node_t *next = ordered->next;
+    if (i >= first)
+      ring[(taken + i) % capacity] = std::move(ordered->text);
+    delete ordered;
+    ordered = next;
+  }
+  taken += count;
+  return count;
+}
+
+namespace {
+class text_shadow_entry_t {
+public:
+  uxdevice::text_shadow_cache_t::shadow_image_ptr_t image = {};
+  std::vector<uxdevice::text_shadow_cache_t::ready_t> waiters = {};
+};
+
+typedef std::unordered_map<uxdevice::text_shadow_key_t, text_shadow_entry_t>
+    text_shadow_map_t;
+
+text_shadow_map_t &text_shadow_map(void) {
+  static text_shadow_map_t shadows = {};
+  return shadows;
+}
+
+std::mutex &text_shadow_mutex(void) {
+  static std::mutex m = {};
+  return m;
+}
+
+uxdevice::background_work_t &text_shadow_work(void) {
+  static uxdevice::background_work_t work(1);
+  return work;
+}
+} // namespace
+
+/**
+\internal
+\fn text_shadow_cache_t::acquire
+\param const text_shadow_key_t &key - the layout and shadow parameters.
+\param const rasterize_t &fn_rasterize - draws the text with the shadow
+brush into a new surface. Only called when the shadow is not within the
+cache.
+\param const ready_t &fn_ready - called once the shadow becomes ready when it
+is not ready yet. May be empty.
+
+\brief returns the shared shadow for the key. The rasterization is performed
+on the calling thread as it uses the layout. The blur, which is the costly
+part, is performed on the background thread.
+*/
+uxdevice::text_shadow_cache_t::shadow_image_ptr_t
+uxdevice::text_shadow_cache_t::acquire(const text_shadow_key_t &key,
+                                       const rasterize_t &fn_rasterize,
+                                       const ready_t &fn_ready) {
+  shadow_image_ptr_t image = {};
+  {
+    std::lock_guard<std::mutex> lock(text_shadow_mutex());
+    auto &shadows = text_shadow_map();
+
+    auto n = shadows.find(key);
+    if (n != shadows.end()) {
+      if (!n->second.image->is_ready() && fn_ready)
+        n->second.waiters.emplace_back(fn_ready);
+      return n->second.image;
+    }
+
+    if (shadows.size() >= limit)
+      trim();
+
+    image = std::make_shared<shadow_image_t>();
+    auto &entry = shadows[key];
+    entry.image = image;
+    if (fn_ready)
+      entry.waiters.emplace_back(fn_ready);
+  }
+
+  cairo_surface_t *surface = fn_rasterize();
+  unsigned int radius = key.radius;
+
+  text_shadow_work().submit([image, surface, radius, key]() {
+    if (surface) {
+      blur_image(surface, radius);
+      image->surface = surface;
+    }
+
+    std::vector<ready_t> waiters = {};
+    {
+      std::lock_guard<std::mutex> lock(text_shadow_mutex());
+      image->ready = true;
+      auto n = text_shadow_map().find(key);
+      if (n != text_shadow_map().end() && n->second.image == image)
+        waiters = std::move(n->second.waiters);
+    }
+    for (auto &fn : waiters)
+      fn();
+  });
+
+  return image;
+}
+
+/**
+\internal
+\fn text_shadow_cache_t::trim
+\brief releases completed shadows that are only referenced by the cache.
+Called with the cache locked.
+*/
+void uxdevice::text_shadow_cache_t::trim(void) {
+  auto &shadows = text_shadow_map();
+  for (auto n = shadows.begin(); n != shadows.end();) {
+    if (n->second.image.use_count() == 1 && n->second.image->is_ready())
+      n = shadows.erase(n);
+    else
+      n++;
+  }
+}
+
+/**
+\fn text_shadow_cache_t::clear
+\brief releases the completed cache entries. Shadows in use by text objects
+remain valid until those objects release them.
+*/
+void uxdevice::text_shadow_cache_t::clear(void) {
+  std::lock_guard<std::mutex> lock(text_shadow_mutex());
+  auto &shadows = text_shadow_map();
+  for (auto n = shadows.begin(); n != shadows.end();) {
+    if (n->second.image->is_ready())
+      n = shadows.erase(n);
+    else
+      n++;
+  }
+}
+
+namespace {
+typedef std::unordered_map<std::string, PangoFontDescription *>
+    font_description_map_t;
+
+font_description_map_t &font_description_map(void) {
+  static font_description_map_t descriptions = {};
+  return descriptions;
+}
+
+std::mutex &font_description_mutex(void) {
+  static std::mutex m = {};
+  return m;
+}
+
+uxdevice::background_work_t &font_prewarm_work(void) {
+  static uxdevice::background_work_t work(1);
+  return work;
+}
+} // namespace
+
+/**
+\internal
+\fn font_registry_t::description
+\brief returns the parsed description for the string, parsing it on first
+use. nullptr is returned when pango cannot parse the string.
+*/
+const PangoFontDescription *
+uxdevice::font_registry_t::description(const std::string &s) {
+  std::lock_guard<std::mutex> lock(font_description_mutex());
+  auto &descriptions = font_description_map();
+  auto it = descriptions.find(s);
+  if (it != descriptions.end())
+    return it->second;
+
+  PangoFontDescription *font = pango_font_description_from_string(s.data());
+  descriptions[s] = font;
+  return font;
+}
+
+/**
+\fn font_registry_t::prewarm
+\brief parses the descriptions and loads each font through the default font
+map on a background thread. Loading the font and its metrics causes
+fontconfig to build its configuration and open the font files, the costly
+part of the first use of a font. The call returns at once.
+*/
+void uxdevice::font_registry_t::prewarm(
+    const std::vector<std::string> &descriptions) {
+  font_prewarm_work().submit([descriptions]() {
+    PangoFontMap *map = pango_cairo_font_map_get_default();
+    PangoContext *context = pango_font_map_create_context(map);
+    for (auto &s : descriptions) {
+      const PangoFontDescription *desc = description(s);
+      if (!desc)
+        continue;
+      PangoFont *font = pango_font_map_load_font(map, context, desc);
+      if (!font)
+        continue;
+      PangoFontMetrics *metrics = pango_font_get_metrics(font, nullptr);
+      if (metrics)
+        pango_font_metrics_unref(metrics);
+      g_object_unref(font);
+    }
+    g_object_unref(context);
+  });
+}
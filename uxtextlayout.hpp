@@ -0,0 +1,491 @@
+/*
+ * This file is part of the PLATFORM_OBJ distribution
+ * {https://github.com/amatarazzo777/platform_obj). Copyright (c) 2020 Anthony
+ * Matarazzo.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+\author Anthony Matarazzo
+\file uxtextlayout.hpp
+\date 10/18/20
+\version 1.0
+\details Shared text layout services. Text objects that have the same text
+and layout parameters share one shaped PangoLayout and its extents.
+
+*/
+#pragma once
+
+/**
+\internal
+\class text_layout_key_t
+\brief the parameters that determine the shape of a text layout. Keys are
+hashed by the hash of the text and compared by the text itself, so texts
+with the same hash are not confused. Optional parameters that are not set
+keep their default values. Interactive layouts are shaped with gray font
+antialiasing for frames drawn during interaction.
+*/
+namespace uxdevice {
+class text_layout_key_t {
+public:
+  bool operator==(const text_layout_key_t &other) const noexcept {
+    return text_hash == other.text_hash && width == other.width &&
+           height == other.height && alignment == other.alignment &&
+           indent == other.indent && line_space == other.line_space &&
+           ellipsize == other.ellipsize &&
+           tab_stops_hash == other.tab_stops_hash &&
+           interactive == other.interactive &&
+           font_description == other.font_description && text == other.text;
+  }
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, text_hash, font_description, width, height,
+                 alignment, indent, line_space, ellipsize, tab_stops_hash,
+                 interactive);
+    return __value;
+  }
+
+  std::size_t text_hash = {};
+  std::string text = {};
+  std::string font_description = {};
+  int width = -1;
+  int height = -1;
+  int alignment = -1;
+  double indent = {};
+  double line_space = {};
+  int ellipsize = -1;
+  std::size_t tab_stops_hash = {};
+  bool interactive = false;
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_layout_key_t);
+
+/**
+\internal
+\class glyph_key_t
+\brief identifies a rasterized glyph within the glyph atlas. The font is
+represented by the hash of its description including the size. The
+subpixel value is the horizontal position in fractions of a pixel.
+*/
+namespace uxdevice {
+class glyph_key_t {
+public:
+  bool operator==(const glyph_key_t &other) const noexcept {
+    return font_hash == other.font_hash && glyph == other.glyph &&
+           subpixel == other.subpixel;
+  }
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, font_hash, glyph, subpixel);
+    return __value;
+  }
+
+  std::size_t font_hash = {};
+  PangoGlyph glyph = {};
+  int subpixel = {};
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::glyph_key_t);
+
+namespace uxdevice {
+/**
+\internal
+\class glyph_atlas_t
+\brief a process wide A8 surface holding glyphs rasterized once per font,
+size and subpixel position. The coverage mask of a laid out text is composed
+by copying glyph cells from the atlas. The text is then painted with the
+text_color_t brush through the mask. When the atlas is full it is cleared and
+filled again. Masks already composed are not affected.
+*/
+class glyph_atlas_t {
+public:
+  static cairo_surface_t *layout_mask(PangoLayout *layout, int &origin_x,
+                                      int &origin_y);
+  static void clear(void);
+
+  static constexpr int atlas_size = 1024;
+  static constexpr int subpixel_positions = 4;
+};
+
+/**
+\internal
+\class text_layout_t
+\brief a shaped layout held by the text layout cache. The layout is fully
+computed before it is shared and must not be changed by its users. Its fonts
+belong to the font map of the thread that shaped it, which that thread keeps
+using, so the font map lock is held while the layout is drawn. Pango font
+maps are not thread safe.
+*/
+class text_layout_t {
+public:
+  text_layout_t() = delete;
+  text_layout_t(PangoLayout *_layout,
+                const std::shared_ptr<std::mutex> &_font_map_lock)
+      : layout(_layout), font_map_lock(_font_map_lock) {
+    pango_layout_get_pixel_extents(layout, &ink_rect, &logical_rect);
+    line_count = pango_layout_get_line_count(layout);
+  }
+  text_layout_t(const text_layout_t &other) = delete;
+  text_layout_t &operator=(const text_layout_t &other) = delete;
+  ~text_layout_t() {
+    if (mask)
+      cairo_surface_destroy(mask);
+    if (layout)
+      g_object_unref(layout);
+  }
+
+  /// @brief the A8 glyph coverage of the layout, composed from the glyph
+  /// atlas on first use. mask_x and mask_y locate the mask relative to the
+  /// layout origin.
+  cairo_surface_t *glyph_mask(void) {
+    std::call_once(mask_once, [this]() {
+      std::lock_guard<std::mutex> guard(*font_map_lock);
+      mask = glyph_atlas_t::layout_mask(layout, mask_x, mask_y);
+    });
+    return mask;
+  }
+
+  /// @brief draws the layout at the current point.
+  void show(cairo_t *cr) {
+    std::lock_guard<std::mutex> guard(*font_map_lock);
+    pango_cairo_show_layout(cr, layout);
+  }
+
+  /// @brief adds the outline of the layout at the current point to the path.
+  void path(cairo_t *cr) {
+    std::lock_guard<std::mutex> guard(*font_map_lock);
+    pango_cairo_layout_path(cr, layout);
+  }
+
+  PangoLayout *layout = nullptr;
+  PangoRectangle ink_rect = PangoRectangle();
+  PangoRectangle logical_rect = PangoRectangle();
+  int line_count = {};
+  std::shared_ptr<std::mutex> font_map_lock = {};
+
+  cairo_surface_t *mask = nullptr;
+  int mask_x = {};
+  int mask_y = {};
+
+private:
+  std::once_flag mask_once = {};
+};
+
+/**
+\internal
+\class text_layout_cache_t
+\brief process wide cache of shaped text layouts. Each layout is created
+from a pango context private to the thread that shapes it, so they do not
+depend upon the cairo context of a particular surface and threads shape text
+in parallel. A thread shapes with its font map locked, and layouts are drawn
+with the font map of the thread that shaped them locked. Layouts may be
+shaped on the calling thread with acquire() or by the pool of shaping threads
+with acquire_async(). When the number of entries grows past the limit,
+entries no longer referenced by a text object are released.
+*/
+class text_layout_cache_t {
+public:
+  typedef std::function<void(PangoLayout *layout)> layout_setup_t;
+  typedef std::shared_ptr<text_layout_t> text_layout_ptr_t;
+  typedef std::shared_future<text_layout_ptr_t> text_layout_future_t;
+
+  static text_layout_ptr_t acquire(const text_layout_key_t &key,
+                                   const layout_setup_t &fn_setup);
+  static text_layout_future_t acquire_async(const text_layout_key_t &key,
+                                            const layout_setup_t &fn_setup);
+  static void clear(void);
+
+  static constexpr std::size_t limit = 8192;
+
+private:
+  static text_layout_ptr_t shape(bool interactive,
+                                 const layout_setup_t &fn_setup);
+  static bool find_or_insert(const text_layout_key_t &key,
+                             std::promise<text_layout_ptr_t> &promise,
+                             text_layout_future_t &future);
+  static void trim(void);
+};
+
+/**
+\class text_measure_t
+\brief a text to be measured without drawing it. The font description
+replaces the text_font_t of the context when it is not empty. A width of zero
+or less does not wrap the text. The height limits the text only when it is
+ellipsized. When the ellipsize option is not given, the text_ellipsize_t of
+the context is used, as are its other paragraph options.
+*/
+class text_measure_t {
+public:
+  std::string text = {};
+  std::string font_description = {};
+  double width = -1;
+  double height = -1;
+  std::optional<text_ellipsize_options_t> ellipsize = {};
+};
+
+/**
+\class text_extents_t
+\brief the measured extents of a text in pixels.
+*/
+class text_extents_t {
+public:
+  PangoRectangle ink_rect = PangoRectangle();
+  PangoRectangle logical_rect = PangoRectangle();
+  int line_count = {};
+};
+
+/**
+\internal
+\class paragraph_layout_t
+\brief text laid out as a vertical stack of paragraphs, each one a shared
+layout from the text layout cache. When the text changes, the edited range
+is found from the beginning and end it shares with the previous text. Only
+the paragraphs within that range are split and shaped again. Paragraphs
+before and after it reuse their layout and extents. The areas of paragraphs
+that were changed, moved or removed are noted within the damaged list,
+relative to the layout origin.
+*/
+class paragraph_layout_t {
+public:
+  typedef std::function<void(PangoLayout *layout)> options_setup_t;
+
+  class paragraph_t {
+  public:
+    cairo_rectangle_int_t extents(void) const noexcept;
+
+    std::size_t text_hash = {};
+    text_layout_cache_t::text_layout_ptr_t shaped = {};
+    int y = {};
+    // the offset of the paragraph and of the new line ending it, or of the
+    // end of the text, within the text.
+    std::size_t start = {};
+    std::size_t end = {};
+  };
+
+  bool update(const std::string_view &_text, const text_layout_key_t &_key,
+              const options_setup_t &fn_options);
+  bool is_current(const std::string_view &_text) const noexcept {
+    return _text == text;
+  }
+  void show(cairo_t *cr, double x, double y);
+  void path(cairo_t *cr, double x, double y);
+  void mask(cairo_t *cr, double x, double y);
+  bool empty(void) const noexcept { return paragraphs.empty(); }
+
+  std::vector<paragraph_t> paragraphs = {};
+  std::vector<cairo_rectangle_int_t> damaged = {};
+  PangoRectangle ink_rect = PangoRectangle();
+  PangoRectangle logical_rect = PangoRectangle();
+  int height_limit = -1;
+
+private:
+  void damage(const cairo_rectangle_int_t &r);
+  std::pair<std::size_t, std::size_t> visible(cairo_t *cr, double y);
+
+  text_layout_key_t key = {};
+  std::string text = {};
+};
+
+/**
+\internal
+\class text_line_index_t
+\brief the lines of a large block of text held by a mapped file or by a
+buffer owned by the caller. The text is not copied. The offsets of the lines
+are found by a background scan which publishes them in batches, so the
+beginning of the text may be shown while the remainder is indexed. A line is
+located by its number in constant time.
+
+\details The offsets hold the start of each line. Once the scan completes,
+a final offset past the end of the text is added when the text does not end
+with a new line. The number of lines is therefore one less than the number
+of offsets at all times.
+*/
+class text_line_index_t {
+public:
+  typedef std::function<void(std::size_t lines)> indexed_function_t;
+
+  text_line_index_t(const std::string &file_name);
+  text_line_index_t(const char *_data, std::size_t _size);
+  text_line_index_t(const text_line_index_t &other) = delete;
+  text_line_index_t &operator=(const text_line_index_t &other) = delete;
+  ~text_line_index_t();
+
+  void scan(const indexed_function_t &fn_indexed);
+  bool is_valid(void) const noexcept { return data != nullptr; }
+  bool is_complete(void) const noexcept { return complete; }
+  std::size_t line_count(void) const;
+  std::string_view line(std::size_t n) const;
+
+  static constexpr std::size_t batch_lines = 65536;
+
+private:
+  void scan_lines(indexed_function_t fn_indexed);
+
+  std::unique_ptr<mapped_file_t> file = {};
+  const char *data = nullptr;
+  std::size_t size = {};
+
+  std::vector<std::size_t> offsets = {};
+  mutable std::mutex offsets_mutex = {};
+  std::thread scan_thread = {};
+  std::atomic<bool> cancel = false;
+  std::atomic<bool> complete = false;
+};
+
+/**
+\internal
+\class text_console_buffer_t
+\brief a bounded ring of text lines appended from any thread and consumed
+by the render thread. Appending pushes the line onto a lock free list. The
+render thread takes the whole list with a single exchange and moves it into
+the ring, so neither side waits upon the other. When more lines arrive than
+the ring holds, the oldest are discarded.
+
+\details lines are numbered from zero in the order they were taken. Lines
+with a number below total() - size() have been discarded.
+*/
+class text_console_buffer_t {
+public:
+  text_console_buffer_t(std::size_t _capacity)
+      : capacity(std::max(_capacity, std::size_t{1})) {
+    ring.resize(capacity);
+  }
+  text_console_buffer_t(const text_console_buffer_t &other) = delete;
+  text_console_buffer_t &operator=(const text_console_buffer_t &other) =
+      delete;
+  ~text_console_buffer_t();
+
+  bool append(const std::string_view &text);
+  std::size_t take(void);
+  std::size_t size(void) const noexcept {
+    return std::min(taken.load(), capacity);
+  }
+  std::size_t total(void) const noexcept { return taken; }
+  const std::string &line(std::size_t n) const { return ring[n % capacity]; }
+
+  const std::size_t capacity;
+
+private:
+  class line_node_t {
+  public:
+    std::string text = {};
+    line_node_t *next = nullptr;
+  };
+
+  std::atomic<line_node_t *> pending = nullptr;
+  std::atomic<bool> signaled = false;
+
+  // the ring is used only by the render thread.
+  std::vector<std::string> ring = {};
+  std::atomic<std::size_t> taken = {};
+};
+
+/**
+\internal
+\class text_shadow_key_t
+\brief the parameters that determine a blurred text shadow. The text and its
+layout are represented by the layout key. The shadow is an alpha
+mask painted with the brush, so texts with different shadow brushes share
+it.
+*/
+class text_shadow_key_t {
+public:
+  bool operator==(const text_shadow_key_t &other) const noexcept {
+    return x == other.x && y == other.y && radius == other.radius &&
+           width == other.width && height == other.height &&
+           layout == other.layout;
+  }
+
+  std::size_t hash_code(void) const noexcept {
+    std::size_t __value = {};
+    hash_combine(__value, layout.hash_code(), x, y, radius, width, height);
+    return __value;
+  }
+
+  text_layout_key_t layout = {};
+  double x = {};
+  double y = {};
+  unsigned int radius = {};
+  int width = {};
+  int height = {};
+};
+} // namespace uxdevice
+UX_REGISTER_STD_HASH_SPECIALIZATION(uxdevice::text_shadow_key_t);
+
+namespace uxdevice {
+/**
+\internal
+\class shadow_image_t
+\brief a blurred shadow held by the text shadow cache. The surface is an A8
+mask and may only be used once is_ready() returns true.
+*/
+class shadow_image_t {
+public:
+  shadow_image_t() {}
+  shadow_image_t(const shadow_image_t &other) = delete;
+  shadow_image_t &operator=(const shadow_image_t &other) = delete;
+  ~shadow_image_t() {
+    if (surface)
+      cairo_surface_destroy(surface);
+  }
+
+  bool is_ready(void) const noexcept { return ready; }
+
+  cairo_surface_t *surface = nullptr;
+  std::atomic<bool> ready = false;
+};
+
+/**
+\internal
+\class text_shadow_cache_t
+\brief process wide cache of blurred text shadows. Text objects having the
+same layout and shadow parameters share one surface. A missing shadow is
+rasterized by the caller and blurred on a background thread. The image is
+returned at once and becomes ready later, at which time the functions
+waiting upon it are called from the background thread.
+*/
+class text_shadow_cache_t {
+public:
+  typedef std::function<cairo_surface_t *(void)> rasterize_t;
+  typedef std::function<void(void)> ready_t;
+  typedef std::shared_ptr<shadow_image_t> shadow_image_ptr_t;
+
+  static shadow_image_ptr_t acquire(const text_shadow_key_t &key,
+                                    const rasterize_t &fn_rasterize,
+                                    const ready_t &fn_ready);
+  static void clear(void);
+
+  static constexpr std::size_t limit = 512;
+
+private:
+  static void trim(void);
+};
+
+/**
+\internal
+\class font_registry_t
+\brief process wide registry of parsed font descriptions. Each unique
+description string is parsed once and the result is shared by every text
+object naming it. Descriptions are owned by the registry and remain valid for
+the life of the process. prewarm() resolves a list of fonts on a background
+thread so fontconfig has matched and opened them before the first frame.
+*/
+class font_registry_t {
+public:
+  static const PangoFontDescription *description(const std::string &s);
+  static void prewarm(const std::vector<std::string> &descriptions);
+};
+} // namespace uxdevice